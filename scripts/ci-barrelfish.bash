@@ -59,7 +59,7 @@ if [[ "$1" = "throughput" ]]; then
 	for benchmark in $benchmarks; do
 
 		CSVFILE_ALL=vmops_barrelfish_${benchmark}_threads_all_results.csv
-		echo "thread_id,benchmark,core,ncores,memsize,numainterleave,mappings_size,page_size,memobj,isolation,duration,operations" | tee $CSVFILE_ALL
+		echo "thread_id,benchmark,core,ncores,memsize,numainterleave,mappings_size,page_size,memobj,isolation,duration,operations,cycles,instructions,dtlb_misses,itlb_misses,cycles_user,cycles_kernel,tlb_ipis,call_ipis" | tee $CSVFILE_ALL
 
 		LOGFILE=vmops_barrelfish_${benchmark}_threads_1_logfile.log
 		CSVFILE=vmops_barrelfish_${benchmark}_threads_1_results.csv
@@ -88,7 +88,7 @@ elif [[ "$1" = "latency" ]]; then
 	for benchmark in $benchmarks; do
 
 		THPT_CSVFILE_ALL=vmops_barrelfish_${benchmark}_threads_all_latency_results.csv
-		echo "thread_id,benchmark,core,ncores,memsize,numainterleave,mappings_size,page_size,memobj,isolation,duration,operations" | tee $THPT_CSVFILE_ALL
+		echo "thread_id,benchmark,core,ncores,memsize,numainterleave,mappings_size,page_size,memobj,isolation,duration,operations,cycles,instructions,dtlb_misses,itlb_misses,cycles_user,cycles_kernel,tlb_ipis,call_ipis" | tee $THPT_CSVFILE_ALL
 
 		LOGFILE=vmops_barrelfish_${benchmark}_threads_1_latency_logfile.log
 		THPT_CSVFILE=vmops_barrelfish_${benchmark}_threads_1_throughput_results.csv
@@ -43,7 +43,7 @@ if [[ "$1" = "latency" ]]; then
 
 		THPT_CSVFILE_ALL=tlb_linux_${benchmark}_threads_all_latency_results.csv
 
-		echo "thread_id,benchmark,core,ncores,memsize,numainterleave,mappings_size,page_size,memobj,isolation,duration,operations" | tee $THPT_CSVFILE_ALL
+		echo "thread_id,benchmark,core,ncores,memsize,numainterleave,mappings_size,page_size,memobj,isolation,duration,operations,cycles,instructions,dtlb_misses,itlb_misses,cycles_user,cycles_kernel,tlb_ipis,call_ipis" | tee $THPT_CSVFILE_ALL
 		for cores in 1 `seq $increment $increment $MAX_CORES`; do
 
 	   	    LOGFILE=tlb_linux_${benchmark}_threads_${cores}_latency_logfile.log
@@ -47,7 +47,7 @@ if [[ "$1" = "throughput" ]]; then
 		fi
 
 		CSVFILE_ALL=vmops_linux_${benchmark}_threads_all_throughput_results.csv
-		echo "thread_id,benchmark,core,ncores,memsize,numainterleave,mappings_size,page_size,memobj,isolation,duration,operations" | tee $CSVFILE_ALL
+		echo "thread_id,benchmark,core,ncores,memsize,numainterleave,mappings_size,page_size,memobj,isolation,duration,operations,cycles,instructions,dtlb_misses,itlb_misses,cycles_user,cycles_kernel,tlb_ipis,call_ipis" | tee $CSVFILE_ALL
 		for cores in 1 `seq $increment $increment $MAX_CORES`; do
 
 	   	    LOGFILE=vmops_linux_${benchmark}_threads_${cores}_logfile.log
@@ -75,7 +75,7 @@ elif [[ "$1" = "latency" ]]; then
 
 		THPT_CSVFILE_ALL=vmops_linux_${benchmark}_threads_all_latency_results.csv
 
-		echo "thread_id,benchmark,core,ncores,memsize,numainterleave,mappings_size,page_size,memobj,isolation,duration,operations" | tee $THPT_CSVFILE_ALL
+		echo "thread_id,benchmark,core,ncores,memsize,numainterleave,mappings_size,page_size,memobj,isolation,duration,operations,cycles,instructions,dtlb_misses,itlb_misses,cycles_user,cycles_kernel,tlb_ipis,call_ipis" | tee $THPT_CSVFILE_ALL
 		for cores in 1 `seq 8 $increment $MAX_CORES`; do
 
 	   	    LOGFILE=vmops_linux_${benchmark}_threads_${cores}_latency_logfile.log
@@ -40,7 +40,7 @@ for b in "${bench[@]}"; do
 
                         for memsize in "${memsizes[@]}"; do
                             if [ ! -f "$CSVFILE" ]; then
-                                echo "thread_id,benchmark,core,ncores,memsize,numainterleave,mappings_size,page_size,memobj,isolation,duration,operations" | tee $CSVFILE
+                                echo "thread_id,benchmark,core,ncores,memsize,numainterleave,mappings_size,page_size,memobj,isolation,duration,operations,cycles,instructions,dtlb_misses,itlb_misses,cycles_user,cycles_kernel,tlb_ipis,call_ipis" | tee $CSVFILE
                             fi
                             for cores in `seq 0 $increment $MAX_CORES`; do
                                 cat /proc/interrupts | grep TLB | tee -a $LOGFILE;
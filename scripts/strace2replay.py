@@ -0,0 +1,185 @@
+#!/usr/bin/env python3
+"""
+Script to convert the mmap, munmap and mprotect calls recorded by strace into a replay trace
+
+    strace -f -ttt -e trace=mmap,munmap,mprotect -o app.strace <app>
+    strace2replay.py app.strace app.replay
+    vmops -b replay -Y app.replay
+
+Ranges of mappings that were created before the recording started are ignored. With -f, strace
+splits the calls interrupted by another thread into an unfinished and a resumed line, these are
+joined again at the time of the unfinished line. Calls that cannot be converted are counted and
+reported.
+"""
+import re
+import struct
+import sys
+
+REPLAY_MAGIC = b"VMOPSRPL"
+REPLAY_VERSION = 1
+
+OP_MAP = 0
+OP_UNMAP = 1
+OP_PROTECT = 2
+
+PROT_BITS = {"PROT_READ": 1, "PROT_WRITE": 2, "PROT_EXEC": 4}
+
+PAGE_SIZE = 4096
+
+HEADER = struct.Struct("=8sIIQII")
+RECORD = struct.Struct("=QQQIHBB")
+
+LINE = re.compile(r"^(?:(\d+)\s+)?(\d+\.\d+)\s+(mmap|munmap|mprotect)\((.*)\)\s+=\s+(\S+)")
+UNFINISHED = re.compile(r"^(?:(\d+)\s+)?(\d+\.\d+)\s+((?:mmap|munmap|mprotect)\(.*?)\s*"
+                        r"<unfinished \.\.\.>")
+RESUMED = re.compile(r"^(?:(\d+)\s+)?\d+\.\d+\s+<\.\.\. (mmap|munmap|mprotect) resumed>\s*(.*)")
+CALL = re.compile(r"\b(mmap|munmap|mprotect)\(")
+
+
+def page_align(size):
+    return (size + PAGE_SIZE - 1) // PAGE_SIZE * PAGE_SIZE
+
+
+def parse_prot(prot):
+    return sum(PROT_BITS.get(p.strip(), 0) for p in prot.split("|"))
+
+
+class Slot:
+    def __init__(self, sid, start, size):
+        self.sid = sid
+        self.start = start
+        self.size = size
+        # the live ranges of the mapping, relative to its start
+        self.ranges = [(0, size)]
+        self.partial = False
+
+    def overlap(self, start, size):
+        """returns the live ranges within [start, start + size) relative to the mapping"""
+        lo = start - self.start
+        hi = lo + size
+        return [(max(a, lo), min(b, hi)) for a, b in self.ranges if a < hi and b > lo]
+
+    def remove(self, lo, hi):
+        ranges = []
+        for a, b in self.ranges:
+            if a < lo:
+                ranges.append((a, min(b, lo)))
+            if b > hi:
+                ranges.append((max(a, hi), b))
+        self.ranges = ranges
+
+
+class Converter:
+    def __init__(self):
+        self.records = []
+        self.live = []
+        self.free = []
+        self.nslots = 0
+        self.tids = {}
+        self.t_first = None
+
+    def emit(self, t, tid, op, slot, offset, size, prot):
+        self.records.append((t, offset, size, slot, tid, op, prot))
+
+    def unmap(self, t, tid, start, size):
+        for slot in list(self.live):
+            for lo, hi in slot.overlap(start, size):
+                slot.remove(lo, hi)
+                self.emit(t, tid, OP_UNMAP, slot.sid, lo, hi - lo, 0)
+                if slot.ranges:
+                    slot.partial = True
+                    continue
+
+                # only a slot that is unmapped as a whole can be mapped again
+                self.live.remove(slot)
+                if not slot.partial:
+                    self.free.append(slot.sid)
+
+    def handle(self, pid, ts, call, args, ret):
+        if ret.startswith("-1"):
+            return True
+
+        # the call did not return, e.g. the process exited while it was unfinished
+        if ret == "?":
+            return False
+
+        t = int(float(ts) * 1e9)
+        if self.t_first is None:
+            self.t_first = t
+        t -= self.t_first
+
+        tid = self.tids.setdefault(pid, len(self.tids))
+        args = [a.strip() for a in args.split(",")]
+
+        if call == "mmap":
+            start = int(ret, 16)
+            size = page_align(int(args[1]))
+            # a fixed mapping replaces the mappings it overlaps
+            self.unmap(t, tid, start, size)
+            sid = self.free.pop() if self.free else self.nslots
+            self.nslots = max(self.nslots, sid + 1)
+            self.live.append(Slot(sid, start, size))
+            self.emit(t, tid, OP_MAP, sid, 0, size, parse_prot(args[2]))
+        elif call == "munmap":
+            self.unmap(t, tid, int(args[0], 16), page_align(int(args[1])))
+        elif call == "mprotect":
+            start = int(args[0], 16)
+            size = page_align(int(args[1]))
+            prot = parse_prot(args[2])
+            for slot in self.live:
+                for lo, hi in slot.overlap(start, size):
+                    self.emit(t, tid, OP_PROTECT, slot.sid, lo, hi - lo, prot)
+
+        return True
+
+    def write(self, path):
+        with open(path, "wb") as f:
+            f.write(HEADER.pack(REPLAY_MAGIC, REPLAY_VERSION, RECORD.size, len(self.records),
+                                self.nslots, len(self.tids)))
+            for rec in self.records:
+                f.write(RECORD.pack(*rec))
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 3:
+        print("usage: {} <strace output> <replay trace>".format(sys.argv[0]))
+        sys.exit(1)
+
+    conv = Converter()
+    pending = {}
+    skipped = 0
+    with open(sys.argv[1]) as f:
+        for line in f:
+            # the start of a call that another thread interrupted, until it is resumed
+            m = UNFINISHED.match(line)
+            if m:
+                pid = m.group(1) or "0"
+                if pid in pending:
+                    skipped += 1
+                pending[pid] = (m.group(2), m.group(3))
+                continue
+
+            m = RESUMED.match(line)
+            if m:
+                pid = m.group(1) or "0"
+                start = pending.pop(pid, None)
+                if start is None or not start[1].startswith(m.group(2) + "("):
+                    skipped += 1
+                    continue
+                line = "{} {} {}{}".format(pid, start[0], start[1], m.group(3))
+
+            m = LINE.match(line)
+            if m:
+                if not conv.handle(m.group(1) or "0", *m.groups()[1:]):
+                    skipped += 1
+            elif CALL.search(line):
+                skipped += 1
+
+    skipped += len(pending)
+    if skipped:
+        print("warning: skipped {} calls that could not be converted".format(skipped),
+              file=sys.stderr)
+
+    conv.write(sys.argv[2])
+    print("converted {} operations on {} slots of {} threads".format(
+        len(conv.records), conv.nslots, len(conv.tids)))
@@ -14,14 +14,29 @@
 
 #include "../platform/platform.h"
 #include "../logging.h"
+#include "histogram.h"
 
 ///< the default rate of sampling
 #define DEFAULT_SAMPLING_RATE_MS 0
 
 
-///< the number of basic mappings that are being crated
+///< the default number of mappings that populate the address space of the benchmark
 #define BENCHMARK_PREPOPULATE_MAPPINGS 128
 
+///< the accesses that fault in the pages of the fault benchmark
+typedef enum {
+    VMOPS_FAULT_READ,        ///< read the page
+    VMOPS_FAULT_WRITE,       ///< write the page
+    VMOPS_FAULT_READ_WRITE,  ///< read the page, then write it
+} vmops_fault_t;
+
+///< the sub-ranges of a mapping the protect benchmark changes the permissions of
+typedef enum {
+    VMOPS_SPLIT_NONE,    ///< the whole mapping
+    VMOPS_SPLIT_STRIDE,  ///< every n-th page of the mapping
+    VMOPS_SPLIT_RANDOM,  ///< a random page of the mapping
+} vmops_split_t;
+
 struct vmops_bench_cfg
 {
     const char *benchmark;
@@ -32,34 +47,144 @@ struct vmops_bench_cfg
     uint32_t time_ms;
     uint32_t stats;
     int32_t rate;
+    uint64_t oprate;
+    uint32_t sampler_ms;
+    uint32_t warmup_ms;
+    double steady_cv;
+    uint32_t reps;
+    double reps_ci;
+    const char *tracefile;
+    uint32_t unmappers;
+    int32_t victims;
+    uint32_t victim_pages;
+    uint32_t unmap_batch;
+    vmops_fault_t fault;
+    vmops_split_t split;
+    uint32_t split_stride;
+    const char *mix;
+    uint64_t seed;
+    const char *replayfile;
+    plat_remap_t remap;
+    plat_memobj_type_t memobj;
+    const char *memobj_dir;
+    plat_page_t pages;
+    size_t page_size;
+    size_t population;
+    size_t population_max;
+    size_t vmas;
+    int argc;
+    char **argv;
+    plat_timer_t timer;
+    bool perfctr;
     bool nounmap;
     bool shared;
     bool isolated;
     bool map4k;
-    bool maphuge;
+    bool ranged;
+    bool processes;
     bool numainterleave;
+    bool replaytimed;
 };
 
+///< the type of a recorded operation
+typedef enum {
+    VMOPS_OP_MAP,
+    VMOPS_OP_UNMAP,
+    VMOPS_OP_PROTECT,
+    VMOPS_OP_FAULT,
+    VMOPS_OP_DISCARD,
+    VMOPS_OP_REMAP,
+    VMOPS_OP_DIRTY,
+    VMOPS_OP_SYNC,
+    VMOPS_OP_SPLIT,
+    VMOPS_OP_MERGE,
+    VMOPS_OP_MAX
+} vmops_op_t;
+
 struct statval
 {
     uint32_t tid;
+    uint32_t op;
     plat_time_t t_elapsed;
     uint64_t counter;
     plat_time_t val;
 };
 
+///< the progress of a thread, published on its own cache line
+struct vmops_progress
+{
+    uint64_t ops;
+} __attribute__((aligned(PLAT_ARCH_CACHELINE_SIZE)));
+
 struct vmops_stats
 {
+    struct vmops_progress *progress;
+    struct vmops_trace_ring *ring;
+    struct vmops_hist hist[VMOPS_OP_MAX];
     struct statval *values;
     size_t idx;
     size_t idx_max;
-    size_t dryrun;
+    bool warmup;
     plat_time_t sampling_delta;
-    plat_time_t sampling_next;
+    plat_time_t sampling_next[VMOPS_OP_MAX];
+    plat_time_t pacing_delta;
+    plat_time_t pacing_next;
 };
 
 #define VMOPS_STATS_MAX 10000000
 
+///< the number of throughput samples in the sliding window of the steady-state detection
+#define VMOPS_WARMUP_WINDOW 10
+
+///< the interval between two throughput samples of the steady-state detection in ms
+#define VMOPS_WARMUP_INTERVAL_MS 10
+
+///< the maximum duration of the warmup if no warmup time is given
+#define VMOPS_WARMUP_MAX_MS 10000
+
+struct vmops_warmup
+{
+    plat_time_t t_end;                 ///< the common end of the measured window, 0 in warmup
+    plat_time_t t_deadline;            ///< the warmup ends at the latest at this time
+    plat_time_t t_last;                ///< the time of the last throughput sample
+    uint64_t ops;                      ///< the total operations at the last throughput sample
+    uint32_t nsamples;                 ///< the number of throughput samples taken
+    double thpt[VMOPS_WARMUP_WINDOW];  ///< the sliding window of throughput samples
+};
+
+///< the time between releasing the threads and the common start of the measured window
+#define VMOPS_WINDOW_START_DELAY_MS 1
+
+///< the common start of the measured window of all threads
+struct vmops_window
+{
+    plat_time_t t_released;  ///< the time the threads were released to start the window
+    plat_time_t t_start;     ///< the time all threads start the measured window
+};
+
+///< the minimum number of repetitions before the confidence interval is considered
+#define VMOPS_REPS_MIN 3
+
+///< the maximum number of repetitions if no repetition count is given
+#define VMOPS_REPS_MAX 30
+
+struct vmops_reps
+{
+    bool done;      ///< set once no further repetitions are to be run
+    bool failed;    ///< set once a thread failed a repetition, which invalidates all of them
+    uint32_t n;     ///< the number of completed repetitions
+    uint32_t max;   ///< the maximum number of repetitions
+    double *thpt;   ///< the throughput of each completed repetition in ops per second
+};
+
+/*
+ * The arguments double as the state of a benchmark thread. Each thread's arguments start on
+ * their own page such that they share no cache line with another thread and can be placed on
+ * the thread's local NUMA node. The window of the first thread's arguments is shared by all
+ * threads, t_wake and t_late hold the largest start skew of the thread over all repetitions.
+ * Benchmarks that split mappings record the number of mappings the thread observed in vmas.
+ * Background threads only put load on the system and are not part of the benchmark result.
+ */
 struct vmops_bench_run_arg
 {
     struct vmops_bench_cfg *cfg;
@@ -71,8 +196,23 @@ struct vmops_bench_run_arg
     size_t count;
     double duration;
     void *shared;
+    plat_thread_fn_t runfn;
+    plat_perfctr_t perfctr;
+    uint64_t perfctr_start[PLAT_PERFCTR_MAX];
+    uint64_t perfctr_delta[PLAT_PERFCTR_MAX];
+    struct vmops_warmup *warmup;
+    struct vmops_reps *reps;
+    struct vmops_trace *trace;
+    plat_irqstats_t irqstats;
+    struct plat_irqcounts *irqcounts;
     struct vmops_stats stats;
-};
+    struct vmops_progress progress;
+    struct vmops_window window;
+    plat_time_t t_wake;
+    plat_time_t t_late;
+    size_t vmas;
+    bool background;
+} __attribute__((aligned(PLAT_ARCH_BASE_PAGE_SIZE)));
 
 
 /**
@@ -106,6 +246,56 @@ int vmops_bench_run_protect(struct vmops_bench_cfg *cfg, const char *opts);
  */
 int vmops_bench_run_protect_elevate(struct vmops_bench_cfg *cfg, const char *opts);
 
+/**
+ * @brief starts the page fault benchmark
+ *
+ * @param cfg   the benchmark configuration
+ * @param opts  the options for the benchmark
+ *
+ * @returns 0 success, -1 error
+ */
+int vmops_bench_run_fault(struct vmops_bench_cfg *cfg, const char *opts);
+
+/**
+ * @brief starts the mremap benchmark
+ *
+ * @param cfg   the benchmark configuration
+ * @param opts  the options for the benchmark
+ *
+ * @returns 0 success, -1 error
+ */
+int vmops_bench_run_mremap(struct vmops_bench_cfg *cfg, const char *opts);
+
+/**
+ * @brief starts the msync benchmark
+ *
+ * @param cfg   the benchmark configuration
+ * @param opts  the options for the benchmark
+ *
+ * @returns 0 success, -1 error
+ */
+int vmops_bench_run_msync(struct vmops_bench_cfg *cfg, const char *opts);
+
+/**
+ * @brief starts the mixed operations benchmark
+ *
+ * @param cfg   the benchmark configuration
+ * @param opts  the options for the benchmark
+ *
+ * @returns 0 success, -1 error
+ */
+int vmops_bench_run_mix(struct vmops_bench_cfg *cfg, const char *opts);
+
+/**
+ * @brief starts the trace replay benchmark
+ *
+ * @param cfg   the benchmark configuration
+ * @param opts  the options for the benchmark
+ *
+ * @returns 0 success, -1 error
+ */
+int vmops_bench_run_replay(struct vmops_bench_cfg *cfg, const char *opts);
+
 /**
  * @brief starts the tlbshootdown benchmark
  *
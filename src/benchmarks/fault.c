@@ -0,0 +1,213 @@
+/*
+ * Virtual Memory Operations Benchmark
+ *
+ * Copyright 2020 Reto Achermann
+ * SPDX-License-Identifier: GPL-3.0
+ */
+
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "benchmarks.h"
+#include "utils.h"
+
+
+/**
+ * @brief faults in a page of a demand-paged mapping
+ *
+ * @param page  the page to be accessed
+ * @param fault the kind of access
+ */
+static inline void fault_touch(volatile uint8_t *page, vmops_fault_t fault)
+{
+    switch (fault) {
+    case VMOPS_FAULT_READ:
+        (void)*page;
+        break;
+    case VMOPS_FAULT_WRITE:
+        *page = 1;
+        break;
+    case VMOPS_FAULT_READ_WRITE:
+        *page = *page + 1;
+        break;
+    }
+}
+
+
+static void *bench_run_fn(struct vmops_bench_run_arg *args)
+{
+    plat_error_t err;
+
+    struct vmops_bench_cfg *cfg = args->cfg;
+
+    plat_time_t t_delta = plat_convert_time(args->cfg->time_ms);
+    if (t_delta == 0) {
+        t_delta = PLAT_TIME_MAX;
+    }
+
+    size_t nops = cfg->nops;
+    if (nops == 0) {
+        nops = SIZE_MAX;
+    }
+
+    size_t pagesize = plat_page_size(cfg->pages);
+
+    /* the thread faults in its slice of the shared mapping, or all pages of its own mapping */
+    uint8_t *addr;
+    size_t size;
+    if (cfg->shared) {
+        size_t npages = cfg->memsize / pagesize;
+        size_t first = npages * args->tid / cfg->corelist_size;
+        size_t last = npages * (args->tid + 1) / cfg->corelist_size;
+        addr = (uint8_t *)args->shared + first * pagesize;
+        size = (last - first) * pagesize;
+    } else {
+        void *map = cfg->isolated ? utils_vmops_get_map_address(args->tid) : NULL;
+        err = plat_vm_map_lazy(&map, cfg->memsize, args->memobj, 0, cfg->pages);
+        if (err != PLAT_ERR_OK) {
+            LOG_ERR("thread %d failed to map memory. exiting.\n", args->tid);
+            return NULL;
+        }
+        addr = (uint8_t *)map;
+        size = cfg->memsize;
+    }
+
+    /* earlier runs may have faulted in the pages, a failed thread still joins the window */
+    err = plat_vm_discard(addr, size, args->memobj);
+    if (err != PLAT_ERR_OK) {
+        LOG_ERR("thread %d. failed to discard memory!\n", args->tid);
+    }
+
+    LOG_INFO("thread %d ready.\n", args->tid);
+    plat_time_t t_current = vmops_utils_window_begin(args);
+
+    plat_time_t t_end = t_delta == PLAT_TIME_MAX ? PLAT_TIME_MAX : t_current + t_delta;
+    plat_time_t t_start = t_current;
+
+    size_t counter = 0;
+    size_t offset = 0;
+    while (err == PLAT_ERR_OK && t_current < t_end && counter < nops) {
+        /* all pages have been faulted in, release them to fault them in again */
+        if (offset == size) {
+            err = plat_vm_discard(addr, size, args->memobj);
+            if (err != PLAT_ERR_OK) {
+                LOG_ERR("thread %d. failed to discard memory!\n", args->tid);
+                goto err_out;
+            }
+
+            plat_time_t t_discard_end = plat_get_time();
+            vmops_utils_add_stats(&args->stats, VMOPS_OP_DISCARD, args->tid, counter,
+                                  t_discard_end - t_start, t_discard_end - t_current);
+            t_current = t_discard_end;
+            offset = 0;
+        }
+
+        plat_time_t t_op_start = vmops_utils_op_start(&args->stats, t_current);
+        fault_touch(addr + offset, cfg->fault);
+        t_current = plat_get_time();
+
+        vmops_utils_add_stats(&args->stats, VMOPS_OP_FAULT, args->tid, counter,
+                              t_current - t_start, t_current - t_op_start);
+
+        offset += pagesize;
+        counter++;
+        vmops_utils_warmup(args, t_current, &counter, &t_start, &t_end);
+    }
+    t_end = plat_get_time();
+
+    if (err != PLAT_ERR_OK) {
+        goto err_out;
+    }
+
+    args->count = counter;
+    args->duration = plat_time_to_ms(t_end - t_start);
+
+err_out:
+    vmops_utils_window_end(args);
+
+    if (!cfg->shared) {
+        plat_vm_unmap(addr, size);
+    }
+
+    LOG_INFO("thread %d done. ops = %zu, time=%.3f\n", args->tid, counter, args->duration);
+
+    return NULL;
+}
+
+
+/**
+ * @brief starts the page fault benchmark
+ *
+ * @param cfg   the benchmark configuration
+ * @param opts  the options for the benchmark
+ *
+ * @returns 0 success, -1 error
+ */
+int vmops_bench_run_fault(struct vmops_bench_cfg *cfg, const char *opts)
+{
+    plat_error_t err;
+
+    if (vmops_utils_parse_options(opts, cfg)) {
+        LOG_ERR("failed to parse the options\n");
+        return -1;
+    }
+
+    if (cfg->map4k) {
+        LOG_ERR("the fault benchmark does not support option '4k'\n");
+        return -1;
+    }
+
+    size_t pagesize = plat_page_size(cfg->pages);
+    if (cfg->memsize % pagesize) {
+        LOG_ERR("memsize must be a multiple of the page size %zu\n", pagesize);
+        return -1;
+    }
+
+    /* with a shared mapping, the threads split the pages among them */
+    if (cfg->shared && cfg->memsize / pagesize < cfg->corelist_size) {
+        LOG_ERR("the shared mapping needs at least one page per thread. memsize=%zu\n",
+                cfg->memsize);
+        return -1;
+    }
+
+    LOG_INFO("Preparing benchmark. 'fault' with options '%s'\n", vmops_utils_print_options(cfg));
+    LOG_INFO("each operation faults in one page of %zu bytes\n", pagesize);
+
+    struct vmops_bench_run_arg *args;
+    if (vmops_utils_prepare_args(cfg, NULL, &args)) {
+        LOG_ERR("failed to prepare arguments\n");
+        return -1;
+    }
+
+    void *addr = NULL;
+    if (cfg->shared) {
+        addr = cfg->isolated ? utils_vmops_get_map_address(0) : NULL;
+        err = plat_vm_map_lazy(&addr, cfg->memsize, args->memobj, 0, cfg->pages);
+        if (err != PLAT_ERR_OK) {
+            LOG_ERR("failed to map the shared memory\n");
+            vmops_utils_cleanup_args(args);
+            return -1;
+        }
+
+        for (uint32_t i = 0; i < cfg->corelist_size; i++) {
+            args[i].shared = addr;
+        }
+    }
+
+    if (vmops_utils_run_benchmark(cfg->corelist_size, args, bench_run_fn)) {
+        LOG_ERR("failed to run the benchmark\n");
+        return -1;
+    }
+
+    vmops_utils_print_csv(args);
+
+    if (addr != NULL) {
+        plat_vm_unmap(addr, cfg->memsize);
+    }
+
+    vmops_utils_cleanup_args(args);
+
+    return 0;
+}
@@ -0,0 +1,171 @@
+/*
+ * Virtual Memory Operations Benchmark
+ *
+ * Copyright 2020 Reto Achermann
+ * SPDX-License-Identifier: GPL-3.0
+ */
+
+#include <string.h>
+
+#include "histogram.h"
+
+
+/**
+ * @brief obtains the highest value that falls into the bucket
+ *
+ * @param idx   the bucket index
+ *
+ * @returns largest value of the bucket
+ */
+static uint64_t hist_bucket_value(uint32_t idx)
+{
+    if (idx < VMOPS_HIST_SUB_COUNT) {
+        return idx;
+    }
+
+    uint32_t shift = idx / VMOPS_HIST_SUB_COUNT - 1;
+    uint64_t sub = idx - shift * VMOPS_HIST_SUB_COUNT;
+
+    /* the topmost bucket wraps around to UINT64_MAX */
+    return ((sub + 1) << shift) - 1;
+}
+
+
+/**
+ * @brief obtains the lowest value that falls into the bucket
+ *
+ * @param idx   the bucket index
+ *
+ * @returns smallest value of the bucket
+ */
+static uint64_t hist_bucket_value_low(uint32_t idx)
+{
+    if (idx < VMOPS_HIST_SUB_COUNT) {
+        return idx;
+    }
+
+    uint32_t shift = idx / VMOPS_HIST_SUB_COUNT - 1;
+    uint64_t sub = idx - shift * VMOPS_HIST_SUB_COUNT;
+
+    return sub << shift;
+}
+
+
+/**
+ * @brief clears all recorded values of the histogram
+ *
+ * @param hist  the histogram to reset
+ */
+void vmops_hist_reset(struct vmops_hist *hist)
+{
+    memset(hist, 0, sizeof(*hist));
+    hist->min = UINT64_MAX;
+}
+
+
+/**
+ * @brief adds the recorded values of one histogram to another
+ *
+ * @param dst   the histogram to merge into
+ * @param src   the histogram to be merged
+ */
+void vmops_hist_merge(struct vmops_hist *dst, const struct vmops_hist *src)
+{
+    if (src->count == 0) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < VMOPS_HIST_BUCKETS; i++) {
+        dst->buckets[i] += src->buckets[i];
+    }
+
+    dst->count += src->count;
+    dst->sum += src->sum;
+    if (src->min < dst->min) {
+        dst->min = src->min;
+    }
+    if (src->max > dst->max) {
+        dst->max = src->max;
+    }
+}
+
+
+/**
+ * @brief removes the recorded values of an earlier snapshot from a histogram
+ *
+ * @param dst   the histogram to subtract from
+ * @param src   an earlier snapshot of the same histogram
+ */
+void vmops_hist_sub(struct vmops_hist *dst, const struct vmops_hist *src)
+{
+    dst->min = UINT64_MAX;
+    dst->max = 0;
+
+    for (uint32_t i = 0; i < VMOPS_HIST_BUCKETS; i++) {
+        dst->buckets[i] -= src->buckets[i];
+        if (dst->buckets[i] == 0) {
+            continue;
+        }
+
+        if (dst->min == UINT64_MAX) {
+            dst->min = hist_bucket_value_low(i);
+        }
+        dst->max = hist_bucket_value(i);
+    }
+
+    dst->count -= src->count;
+    dst->sum -= src->sum;
+}
+
+
+/**
+ * @brief obtains the value at a given percentile
+ *
+ * @param hist  the histogram
+ * @param p     the percentile in the range [0, 100]
+ *
+ * @returns the highest value equivalent to the percentile, 0 if the histogram is empty
+ */
+uint64_t vmops_hist_percentile(const struct vmops_hist *hist, double p)
+{
+    if (hist->count == 0) {
+        return 0;
+    }
+
+    if (p >= 100.0) {
+        return hist->max;
+    }
+
+    uint64_t rank = (uint64_t)((p / 100.0) * (double)hist->count + 0.5);
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < VMOPS_HIST_BUCKETS; i++) {
+        seen += hist->buckets[i];
+        if (seen >= rank) {
+            uint64_t val = hist_bucket_value(i);
+            return val < hist->max ? val : hist->max;
+        }
+    }
+
+    return hist->max;
+}
+
+
+/**
+ * @brief obtains the mean of the recorded values
+ *
+ * @param hist  the histogram
+ *
+ * @returns the mean value, 0 if the histogram is empty
+ */
+double vmops_hist_mean(const struct vmops_hist *hist)
+{
+    if (hist->count == 0) {
+        return 0;
+    }
+
+    return (double)hist->sum / (double)hist->count;
+}
@@ -0,0 +1,132 @@
+/*
+ * Virtual Memory Operations Benchmark
+ *
+ * Copyright 2020 Reto Achermann
+ * SPDX-License-Identifier: GPL-3.0
+ */
+
+#ifndef __VMOPS_HISTOGRAM_H_
+#define __VMOPS_HISTOGRAM_H_ 1
+
+#include <stdint.h>
+
+
+/*
+ * ================================================================================================
+ * Log-Bucketed Latency Histogram
+ * ================================================================================================
+ *
+ * Values are grouped by their most significant bit, and each power of two is split into
+ * VMOPS_HIST_SUB_COUNT linear sub-buckets. Values below VMOPS_HIST_SUB_COUNT are exact, larger
+ * values are recorded with a relative error of at most 1 / VMOPS_HIST_SUB_COUNT.
+ */
+
+
+///< number of bits used for the linear sub-buckets of each power of two
+#define VMOPS_HIST_SUB_BITS 5
+
+///< number of linear sub-buckets per power of two
+#define VMOPS_HIST_SUB_COUNT (1U << VMOPS_HIST_SUB_BITS)
+
+///< total number of buckets required to cover the full 64-bit range
+#define VMOPS_HIST_BUCKETS ((64 - VMOPS_HIST_SUB_BITS + 1) * VMOPS_HIST_SUB_COUNT)
+
+
+struct vmops_hist
+{
+    uint64_t count;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+    uint64_t buckets[VMOPS_HIST_BUCKETS];
+};
+
+
+/**
+ * @brief calculates the bucket index of a value
+ *
+ * @param val   the value to be recorded
+ *
+ * @returns index into the bucket array
+ */
+static inline uint32_t vmops_hist_bucket(uint64_t val)
+{
+    if (val < VMOPS_HIST_SUB_COUNT) {
+        return (uint32_t)val;
+    }
+
+    uint32_t shift = 63 - __builtin_clzll(val) - VMOPS_HIST_SUB_BITS;
+    return shift * VMOPS_HIST_SUB_COUNT + (uint32_t)(val >> shift);
+}
+
+
+/**
+ * @brief records a value in the histogram
+ *
+ * @param hist  the histogram to update
+ * @param val   the value to be recorded
+ */
+static inline void vmops_hist_record(struct vmops_hist *hist, uint64_t val)
+{
+    hist->buckets[vmops_hist_bucket(val)]++;
+    hist->count++;
+    hist->sum += val;
+    if (val < hist->min) {
+        hist->min = val;
+    }
+    if (val > hist->max) {
+        hist->max = val;
+    }
+}
+
+
+/**
+ * @brief clears all recorded values of the histogram
+ *
+ * @param hist  the histogram to reset
+ */
+void vmops_hist_reset(struct vmops_hist *hist);
+
+
+/**
+ * @brief adds the recorded values of one histogram to another
+ *
+ * @param dst   the histogram to merge into
+ * @param src   the histogram to be merged
+ */
+void vmops_hist_merge(struct vmops_hist *dst, const struct vmops_hist *src);
+
+
+/**
+ * @brief removes the recorded values of an earlier snapshot from a histogram
+ *
+ * @param dst   the histogram to subtract from
+ * @param src   an earlier snapshot of the same histogram
+ *
+ * The minimum and maximum of the result are approximated by the bucket bounds.
+ */
+void vmops_hist_sub(struct vmops_hist *dst, const struct vmops_hist *src);
+
+
+/**
+ * @brief obtains the value at a given percentile
+ *
+ * @param hist  the histogram
+ * @param p     the percentile in the range [0, 100]
+ *
+ * @returns the highest value equivalent to the percentile, 0 if the histogram is empty
+ */
+uint64_t vmops_hist_percentile(const struct vmops_hist *hist, double p);
+
+
+/**
+ * @brief obtains the mean of the recorded values
+ *
+ * @param hist  the histogram
+ *
+ * @returns the mean value, 0 if the histogram is empty
+ */
+double vmops_hist_mean(const struct vmops_hist *hist);
+
+
+#endif /* __VMOPS_HISTOGRAM_H_ */
@@ -43,11 +43,9 @@ static void *bench_run_fn(struct vmops_bench_run_arg *args)
     }
 
     LOG_INFO("thread %d ready.\n", args->tid);
-    plat_thread_barrier(args->barrier);
-
+    plat_time_t t_current = vmops_utils_window_begin(args);
 
     size_t memsize = args->cfg->memsize;
-    plat_time_t t_current = plat_get_time();
     plat_time_t t_end = t_delta == PLAT_TIME_MAX ? PLAT_TIME_MAX : t_current + t_delta;
     plat_time_t t_start = t_current;
     size_t counter = 0;
@@ -55,58 +53,69 @@ static void *bench_run_fn(struct vmops_bench_run_arg *args)
     if (cfg->isolated) {
         void *addr = utils_vmops_get_map_address(args->tid);
         while (t_current < t_end && counter < nops) {
-            plat_time_t t_op_start = t_current;
-            err = plat_vm_map_fixed(addr, memsize, args->memobj, 0, cfg->maphuge);
+            plat_time_t t_op_start = vmops_utils_op_start(&args->stats, t_current);
+            err = plat_vm_map_fixed(addr, memsize, args->memobj, 0, cfg->pages);
             if (err != PLAT_ERR_OK) {
                 LOG_ERR("thread %d. failed to map memory ops=%zu!\n", args->tid, counter);
-                return NULL;
+                goto err_out;
             }
 
+            plat_time_t t_map_end = plat_get_time();
+
             err = plat_vm_unmap(addr, memsize);
             if (err != PLAT_ERR_OK) {
                 LOG_ERR("thread %d. failed to unmap memory ops=%zu!\n", args->tid, counter);
-                return NULL;
+                goto err_out;
             }
 
             t_current = plat_get_time();
 
-            vmops_utils_add_stats(&args->stats, args->tid, counter, t_current - t_start,
-                                  t_current - t_op_start);
+            vmops_utils_add_stats(&args->stats, VMOPS_OP_MAP, args->tid, counter,
+                                  t_map_end - t_start, t_map_end - t_op_start);
+            vmops_utils_add_stats(&args->stats, VMOPS_OP_UNMAP, args->tid, counter,
+                                  t_current - t_start, t_current - t_map_end);
 
             counter++;
+            vmops_utils_warmup(args, t_current, &counter, &t_start, &t_end);
         }
     } else {
         while (t_current < t_end && counter < nops) {
-            plat_time_t t_op_start = t_current;
+            plat_time_t t_op_start = vmops_utils_op_start(&args->stats, t_current);
 
             void *addr;
-            err = plat_vm_map(&addr, memsize, args->memobj, 0, cfg->maphuge);
+            err = plat_vm_map(&addr, memsize, args->memobj, 0, cfg->pages);
             if (err != PLAT_ERR_OK) {
                 LOG_ERR("thread %d. failed to map memory ops=%zu!\n", args->tid, counter);
-                return NULL;
+                goto err_out;
             }
 
+            plat_time_t t_map_end = plat_get_time();
+
             err = plat_vm_unmap(addr, memsize);
             if (err != PLAT_ERR_OK) {
                 LOG_ERR("thread %d. failed to unmap memory ops=%zu!\n", args->tid, counter);
-                return NULL;
+                goto err_out;
             }
 
             t_current = plat_get_time();
 
-            vmops_utils_add_stats(&args->stats, args->tid, counter, t_current - t_start,
-                                  t_current - t_op_start);
+            vmops_utils_add_stats(&args->stats, VMOPS_OP_MAP, args->tid, counter,
+                                  t_map_end - t_start, t_map_end - t_op_start);
+            vmops_utils_add_stats(&args->stats, VMOPS_OP_UNMAP, args->tid, counter,
+                                  t_current - t_start, t_current - t_map_end);
 
             counter++;
+            vmops_utils_warmup(args, t_current, &counter, &t_start, &t_end);
         }
     }
     t_end = plat_get_time();
 
-    plat_thread_barrier(args->barrier);
-
     args->count = counter;
     args->duration = plat_time_to_ms(t_end - t_start);
 
+err_out:
+    vmops_utils_window_end(args);
+
     LOG_INFO("thread %d done. ops = %zu, time=%.3f\n", args->tid, counter, args->duration);
 
     return NULL;
@@ -132,7 +141,8 @@ static void *bench_run_4k_fn(struct vmops_bench_run_arg *args)
         nops = SIZE_MAX;
     }
 
-    size_t nmaps = cfg->memsize / PLAT_ARCH_BASE_PAGE_SIZE;
+    size_t pagesize = plat_page_size(cfg->pages);
+    size_t nmaps = cfg->memsize / pagesize;
     void **addrs = calloc(nmaps, sizeof(void *));
     if (addrs == NULL) {
         LOG_ERR("thread %d malloc failed!\n", args->tid);
@@ -142,20 +152,18 @@ static void *bench_run_4k_fn(struct vmops_bench_run_arg *args)
     if (cfg->isolated) {
         void *addr = utils_vmops_get_map_address(args->tid);
         for (size_t i = 0; i < nmaps; i++) {
-            err = plat_vm_map_fixed(addr, PLAT_ARCH_BASE_PAGE_SIZE, args->memobj,
-                                    i * PLAT_ARCH_BASE_PAGE_SIZE, cfg->maphuge);
+            err = plat_vm_map_fixed(addr, pagesize, args->memobj, i * pagesize, cfg->pages);
             if (err != PLAT_ERR_OK) {
                 LOG_ERR("thread %d. failed to map memory i=%zu!\n", args->tid, i);
                 goto cleanup_and_exit;
             }
             addrs[i] = addr;
 
-            addr = (void *)((uintptr_t)addr + PLAT_ARCH_BASE_PAGE_SIZE);
+            addr = (void *)((uintptr_t)addr + pagesize);
         }
     } else {
         for (size_t i = 0; i < nmaps; i++) {
-            err = plat_vm_map(&addrs[i], PLAT_ARCH_BASE_PAGE_SIZE, args->memobj,
-                              i * PLAT_ARCH_BASE_PAGE_SIZE, cfg->maphuge);
+            err = plat_vm_map(&addrs[i], pagesize, args->memobj, i * pagesize, cfg->pages);
             if (err != PLAT_ERR_OK) {
                 LOG_ERR("thread %d. failed to map memory i=%zu!\n", args->tid, i);
                 goto cleanup_and_exit;
@@ -164,48 +172,67 @@ static void *bench_run_4k_fn(struct vmops_bench_run_arg *args)
     }
 
     LOG_INFO("thread %d ready.\n", args->tid);
-    plat_thread_barrier(args->barrier);
+    plat_time_t t_current = vmops_utils_window_begin(args);
 
-
-    plat_time_t t_current = plat_get_time();
     plat_time_t t_end = t_delta == PLAT_TIME_MAX ? PLAT_TIME_MAX : t_current + t_delta;
     plat_time_t t_start = t_current;
 
     if (cfg->isolated) {
         size_t page = args->tid;
         while (t_current < t_end && counter < nops) {
+            plat_time_t t_op_start = vmops_utils_op_start(&args->stats, t_current);
             size_t idx = (page++) % nmaps;
-            err = plat_vm_unmap(addrs[idx], PLAT_ARCH_BASE_PAGE_SIZE);
+            err = plat_vm_unmap(addrs[idx], pagesize);
             if (err != PLAT_ERR_OK) {
                 LOG_ERR("thread %d. failed to unmap memory! %p\n", args->tid, addrs[idx]);
                 goto cleanup_and_exit;
             }
-            err = plat_vm_map_fixed(addrs[idx], PLAT_ARCH_BASE_PAGE_SIZE, args->memobj,
-                                    idx * PLAT_ARCH_BASE_PAGE_SIZE, cfg->maphuge);
+
+            plat_time_t t_unmap_end = plat_get_time();
+
+            err = plat_vm_map_fixed(addrs[idx], pagesize, args->memobj,
+                                    idx * pagesize, cfg->pages);
             if (err != PLAT_ERR_OK) {
                 LOG_ERR("thread %d. failed to map fixed memory! %p\n", args->tid, addrs[idx]);
                 goto cleanup_and_exit;
             }
             t_current = plat_get_time();
+
+            vmops_utils_add_stats(&args->stats, VMOPS_OP_UNMAP, args->tid, counter,
+                                  t_unmap_end - t_start, t_unmap_end - t_op_start);
+            vmops_utils_add_stats(&args->stats, VMOPS_OP_MAP, args->tid, counter,
+                                  t_current - t_start, t_current - t_unmap_end);
+
             counter++;
+            vmops_utils_warmup(args, t_current, &counter, &t_start, &t_end);
         }
     } else {
         size_t page = args->tid;
         while (t_current < t_end && counter < nops) {
+            plat_time_t t_op_start = vmops_utils_op_start(&args->stats, t_current);
             size_t idx = (page++) % nmaps;
-            err = plat_vm_unmap(addrs[idx], PLAT_ARCH_BASE_PAGE_SIZE);
+            err = plat_vm_unmap(addrs[idx], pagesize);
             if (err != PLAT_ERR_OK) {
                 LOG_ERR("thread %d. failed to unmap memory! %p\n", args->tid, addrs[idx]);
                 goto cleanup_and_exit;
             }
-            err = plat_vm_map(&addrs[idx], PLAT_ARCH_BASE_PAGE_SIZE, args->memobj,
-                              idx * PLAT_ARCH_BASE_PAGE_SIZE, cfg->maphuge);
+
+            plat_time_t t_unmap_end = plat_get_time();
+
+            err = plat_vm_map(&addrs[idx], pagesize, args->memobj, idx * pagesize, cfg->pages);
             if (err != PLAT_ERR_OK) {
                 LOG_ERR("thread %d. failed to map memory!\n", args->tid);
                 goto cleanup_and_exit;
             }
             t_current = plat_get_time();
+
+            vmops_utils_add_stats(&args->stats, VMOPS_OP_UNMAP, args->tid, counter,
+                                  t_unmap_end - t_start, t_unmap_end - t_op_start);
+            vmops_utils_add_stats(&args->stats, VMOPS_OP_MAP, args->tid, counter,
+                                  t_current - t_start, t_current - t_unmap_end);
+
             counter++;
+            vmops_utils_warmup(args, t_current, &counter, &t_start, &t_end);
         }
     }
 
@@ -216,11 +243,11 @@ static void *bench_run_4k_fn(struct vmops_bench_run_arg *args)
 
 cleanup_and_exit:
 
-    plat_thread_barrier(args->barrier);
+    vmops_utils_window_end(args);
 
     for (size_t i = 0; i < nmaps; i++) {
         if (addrs[i] != NULL) {
-            err = plat_vm_unmap(addrs[i], PLAT_ARCH_BASE_PAGE_SIZE);
+            err = plat_vm_unmap(addrs[i], pagesize);
             if (err != PLAT_ERR_OK) {
                 LOG_ERR("thread %d. failed to unmap memory!\n", args->tid);
             }
@@ -236,6 +263,58 @@ cleanup_and_exit:
     return NULL;
 }
 
+///< the mappings of a thread that are kept until the window has ended
+struct nounmap_maps
+{
+    void **addrs;  ///< the addresses of the mappings
+    size_t count;  ///< the number of recorded mappings
+    size_t max;    ///< the number of addresses that fit into addrs
+};
+
+
+/**
+ * @brief records a mapping to be unmapped once the window has ended
+ *
+ * @param maps  the mappings of the thread
+ * @param addr  the address of the new mapping
+ *
+ * @returns 0 on success, -1 on failure
+ */
+static int nounmap_record(struct nounmap_maps *maps, void *addr)
+{
+    if (maps->count == maps->max) {
+        size_t max = maps->max ? 2 * maps->max : 1024;
+        void **addrs = realloc(maps->addrs, max * sizeof(void *));
+        if (addrs == NULL) {
+            return -1;
+        }
+        maps->addrs = addrs;
+        maps->max = max;
+    }
+
+    maps->addrs[maps->count++] = addr;
+
+    return 0;
+}
+
+
+/**
+ * @brief unmaps the recorded mappings, such that the next repetition starts from the same
+ *        address space
+ *
+ * @param maps  the mappings of the thread
+ * @param size  the size of each mapping
+ */
+static void nounmap_release(struct nounmap_maps *maps, size_t size)
+{
+    for (size_t i = 0; i < maps->count; i++) {
+        plat_vm_unmap(maps->addrs[i], size);
+    }
+
+    free(maps->addrs);
+}
+
+
 static void *bench_run_nounmap_fn(struct vmops_bench_run_arg *args)
 {
     plat_error_t err;
@@ -253,54 +332,71 @@ static void *bench_run_nounmap_fn(struct vmops_bench_run_arg *args)
     }
 
     LOG_INFO("thread %d ready.\n", args->tid);
-    plat_thread_barrier(args->barrier);
-
+    plat_time_t t_current = vmops_utils_window_begin(args);
 
     size_t memsize = args->cfg->memsize;
-    plat_time_t t_current = plat_get_time();
     plat_time_t t_end = t_delta == PLAT_TIME_MAX ? PLAT_TIME_MAX : t_current + t_delta;
     plat_time_t t_start = t_current;
     plat_time_t t_op_start;
     size_t counter = 0;
 
+    struct nounmap_maps maps = { NULL, 0, 0 };
+
     if (cfg->isolated) {
         void *addr = utils_vmops_get_map_address(args->tid);
         while (t_current < t_end && counter < nops) {
-            t_op_start = t_current;
-            err = plat_vm_map_fixed(addr, memsize, args->memobj, 0, cfg->maphuge);
+            t_op_start = vmops_utils_op_start(&args->stats, t_current);
+            err = plat_vm_map_fixed(addr, memsize, args->memobj, 0, cfg->pages);
             if (err != PLAT_ERR_OK) {
                 LOG_ERR("thread %d. failed to map memory!\n", args->tid);
-                return NULL;
+                goto err_out;
             }
-            addr += memsize;
             t_current = plat_get_time();
+
+            if (nounmap_record(&maps, addr)) {
+                LOG_ERR("thread %d. failed to record the mapping!\n", args->tid);
+                goto err_out;
+            }
+
+            addr += memsize;
             counter++;
-            vmops_utils_add_stats(&args->stats, args->tid, counter, t_current - t_start,
-                                  t_current - t_op_start);
+            vmops_utils_add_stats(&args->stats, VMOPS_OP_MAP, args->tid, counter,
+                                  t_current - t_start, t_current - t_op_start);
+            vmops_utils_warmup(args, t_current, &counter, &t_start, &t_end);
         }
     } else {
         while (t_current < t_end && counter < nops) {
-            t_op_start = t_current;
+            t_op_start = vmops_utils_op_start(&args->stats, t_current);
             void *addr;
-            err = plat_vm_map(&addr, memsize, args->memobj, 0, cfg->maphuge);
+            err = plat_vm_map(&addr, memsize, args->memobj, 0, cfg->pages);
             if (err != PLAT_ERR_OK) {
                 LOG_ERR("thread %d. failed to map memory!\n", args->tid);
-                return NULL;
+                goto err_out;
             }
 
             t_current = plat_get_time();
+
+            if (nounmap_record(&maps, addr)) {
+                LOG_ERR("thread %d. failed to record the mapping!\n", args->tid);
+                goto err_out;
+            }
+
             counter++;
-            vmops_utils_add_stats(&args->stats, args->tid, counter, t_current - t_start,
-                                  t_current - t_op_start);
+            vmops_utils_add_stats(&args->stats, VMOPS_OP_MAP, args->tid, counter,
+                                  t_current - t_start, t_current - t_op_start);
+            vmops_utils_warmup(args, t_current, &counter, &t_start, &t_end);
         }
     }
     t_end = plat_get_time();
 
-    plat_thread_barrier(args->barrier);
-
     args->count = counter;
     args->duration = plat_time_to_ms(t_end - t_start);
 
+err_out:
+    vmops_utils_window_end(args);
+
+    nounmap_release(&maps, memsize);
+
     LOG_INFO("thread %d done. ops = %zu, time=%.3f\n", args->tid, counter, args->duration);
 
     return NULL;
@@ -322,46 +418,68 @@ static void *bench_run_nounmap_4k_fn(struct vmops_bench_run_arg *args)
         nops = SIZE_MAX;
     }
 
-    size_t nmaps = cfg->memsize / PLAT_ARCH_BASE_PAGE_SIZE;
+    size_t pagesize = plat_page_size(cfg->pages);
+    size_t nmaps = cfg->memsize / pagesize;
 
     LOG_INFO("thread %d ready.\n", args->tid);
-    plat_thread_barrier(args->barrier);
+    plat_time_t t_current = vmops_utils_window_begin(args);
 
-
-    plat_time_t t_current = plat_get_time();
     plat_time_t t_end = t_delta == PLAT_TIME_MAX ? PLAT_TIME_MAX : t_current + t_delta;
     plat_time_t t_start = t_current;
     size_t counter = 0;
 
+    struct nounmap_maps maps = { NULL, 0, 0 };
+
     if (cfg->isolated) {
         size_t page = args->tid;
         void *addr = utils_vmops_get_map_address(args->tid);
         while (t_current < t_end && counter < nops) {
+            plat_time_t t_op_start = vmops_utils_op_start(&args->stats, t_current);
             size_t idx = (page++) % nmaps;
 
-            err = plat_vm_map_fixed(addr, PLAT_ARCH_BASE_PAGE_SIZE, args->memobj,
-                                    idx * PLAT_ARCH_BASE_PAGE_SIZE, cfg->maphuge);
+            err = plat_vm_map_fixed(addr, pagesize, args->memobj, idx * pagesize, cfg->pages);
             if (err != PLAT_ERR_OK) {
                 LOG_ERR("thread %d. failed to map memory!\n", args->tid);
                 goto cleanup_and_exit;
             }
-            addr = (void *)((uintptr_t)addr + PLAT_ARCH_BASE_PAGE_SIZE);
             t_current = plat_get_time();
+
+            if (nounmap_record(&maps, addr)) {
+                LOG_ERR("thread %d. failed to record the mapping!\n", args->tid);
+                goto cleanup_and_exit;
+            }
+
+            addr = (void *)((uintptr_t)addr + pagesize);
+
+            vmops_utils_add_stats(&args->stats, VMOPS_OP_MAP, args->tid, counter,
+                                  t_current - t_start, t_current - t_op_start);
+
             counter++;
+            vmops_utils_warmup(args, t_current, &counter, &t_start, &t_end);
         }
     } else {
         size_t page = args->tid;
         while (t_current < t_end && counter < nops) {
+            plat_time_t t_op_start = vmops_utils_op_start(&args->stats, t_current);
             size_t idx = (page++) % nmaps;
             void *addr;
-            err = plat_vm_map(&addr, PLAT_ARCH_BASE_PAGE_SIZE, args->memobj,
-                              idx * PLAT_ARCH_BASE_PAGE_SIZE, cfg->maphuge);
+            err = plat_vm_map(&addr, pagesize, args->memobj, idx * pagesize, cfg->pages);
             if (err != PLAT_ERR_OK) {
                 LOG_ERR("thread %d. failed to map memory counter=%zu!\n", args->tid, counter);
                 goto cleanup_and_exit;
             }
             t_current = plat_get_time();
+
+            if (nounmap_record(&maps, addr)) {
+                LOG_ERR("thread %d. failed to record the mapping!\n", args->tid);
+                goto cleanup_and_exit;
+            }
+
+            vmops_utils_add_stats(&args->stats, VMOPS_OP_MAP, args->tid, counter,
+                                  t_current - t_start, t_current - t_op_start);
+
             counter++;
+            vmops_utils_warmup(args, t_current, &counter, &t_start, &t_end);
         }
     }
 
@@ -372,7 +490,9 @@ static void *bench_run_nounmap_4k_fn(struct vmops_bench_run_arg *args)
 
 cleanup_and_exit:
 
-    plat_thread_barrier(args->barrier);
+    vmops_utils_window_end(args);
+
+    nounmap_release(&maps, pagesize);
 
     LOG_INFO("thread %d done. ops = %zu, time=%.3f\n", args->tid, counter, args->duration);
 
@@ -0,0 +1,366 @@
+/*
+ * Virtual Memory Operations Benchmark
+ *
+ * Copyright 2020 Reto Achermann
+ * SPDX-License-Identifier: GPL-3.0
+ */
+
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "benchmarks.h"
+#include "utils.h"
+
+///< the maximum number of live mappings of a thread
+#define MIX_SLOTS 64
+
+///< the operation mix if none is given
+#define MIX_DEFAULT "map:40,unmap:40,protect:15,fault:5"
+
+///< the operations a mix may consist of
+static const vmops_op_t mix_ops[] = { VMOPS_OP_MAP, VMOPS_OP_UNMAP, VMOPS_OP_PROTECT,
+                                      VMOPS_OP_FAULT, VMOPS_OP_DISCARD };
+
+#define MIX_OPS_MAX (sizeof(mix_ops) / sizeof(mix_ops[0]))
+
+///< the live mappings of a thread
+struct mix_table
+{
+    void *addr[MIX_SLOTS];       ///< the address of the mapping in the slot
+    bool readonly[MIX_SLOTS];    ///< whether the mapping in the slot is read only
+    uint32_t order[MIX_SLOTS];   ///< the first nlive entries are the live slots, then free ones
+    uint32_t nlive;              ///< the number of live mappings
+};
+
+
+/**
+ * @brief parses the operation mix of a thread
+ *
+ * @param spec      the mix of 'op:weight' pairs separated by ',', the mixes separated by '/'
+ * @param tid       the thread
+ * @param weights   returns the weight of each operation
+ *
+ * @returns 0 on success, -1 on failure
+ *
+ * With fewer mixes than threads, the mixes are assigned to the threads round robin.
+ */
+static int mix_parse(const char *spec, uint32_t tid, uint32_t *weights)
+{
+    uint32_t nmixes = 1;
+    for (const char *c = spec; *c; c++) {
+        nmixes += (*c == '/');
+    }
+
+    const char *current = spec;
+    for (uint32_t i = 0; i < tid % nmixes; i++) {
+        current = strchr(current, '/') + 1;
+    }
+
+    memset(weights, 0, VMOPS_OP_MAX * sizeof(uint32_t));
+
+    uint32_t total = 0;
+    while (*current && *current != '/') {
+        const char *sep = strchr(current, ':');
+        if (sep == NULL) {
+            LOG_ERR("expected 'op:weight' in the mix '%s'\n", current);
+            return -1;
+        }
+
+        size_t len = sep - current;
+        uint32_t i;
+        for (i = 0; i < MIX_OPS_MAX; i++) {
+            const char *name = vmops_utils_op_name(mix_ops[i]);
+            if (strlen(name) == len && strncmp(current, name, len) == 0) {
+                break;
+            }
+        }
+
+        if (i == MIX_OPS_MAX) {
+            LOG_ERR("unsupported operation '%.*s' in the mix\n", (int)len, current);
+            return -1;
+        }
+
+        char *end;
+        uint32_t weight = strtoul(sep + 1, &end, 10);
+        if (end == sep + 1 || (*end != 0 && *end != ',' && *end != '/')) {
+            LOG_ERR("invalid weight of operation '%.*s' in the mix\n", (int)len, current);
+            return -1;
+        }
+
+        weights[mix_ops[i]] += weight;
+        total += weight;
+
+        current = *end == ',' ? end + 1 : end;
+    }
+
+    if (total == 0) {
+        LOG_ERR("the mix of thread %u has no operations\n", tid);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+/**
+ * @brief picks the next operation of a thread
+ *
+ * @param weights   the weight of each operation
+ * @param total     the sum of the weights
+ * @param table     the live mappings of the thread
+ * @param rand      the state of the random number generator
+ *
+ * @returns the next operation
+ *
+ * Without live mappings any operation becomes a map, with all slots in use a map becomes an
+ * unmap, such that the executed mix may deviate from the configured one.
+ */
+static vmops_op_t mix_pick(uint32_t *weights, uint32_t total, struct mix_table *table,
+                           uint64_t *rand)
+{
+    uint32_t r = vmops_utils_rand(rand) % total;
+
+    vmops_op_t op = VMOPS_OP_MAP;
+    for (uint32_t i = 0; i < MIX_OPS_MAX; i++) {
+        if (r < weights[mix_ops[i]]) {
+            op = mix_ops[i];
+            break;
+        }
+        r -= weights[mix_ops[i]];
+    }
+
+    if (table->nlive == 0) {
+        return VMOPS_OP_MAP;
+    }
+
+    if (op == VMOPS_OP_MAP && table->nlive == MIX_SLOTS) {
+        return VMOPS_OP_UNMAP;
+    }
+
+    return op;
+}
+
+
+static void *bench_run_fn(struct vmops_bench_run_arg *args)
+{
+    plat_error_t err;
+
+    struct vmops_bench_cfg *cfg = args->cfg;
+
+    plat_time_t t_delta = plat_convert_time(args->cfg->time_ms);
+    if (t_delta == 0) {
+        t_delta = PLAT_TIME_MAX;
+    }
+
+    size_t nops = cfg->nops;
+    if (nops == 0) {
+        nops = SIZE_MAX;
+    }
+
+    size_t memsize = cfg->memsize;
+    size_t pagesize = plat_page_size(cfg->pages);
+    size_t npages = memsize / pagesize;
+
+    /* the mix has been validated before the threads were started */
+    uint32_t weights[VMOPS_OP_MAX];
+    mix_parse(cfg->mix, args->tid, weights);
+
+    uint32_t total = 0;
+    for (uint32_t op = 0; op < VMOPS_OP_MAX; op++) {
+        total += weights[op];
+    }
+
+    uint64_t rand = cfg->seed + args->tid + 1;
+
+    /* with isolated mappings, each slot has its own address in the region of the thread */
+    struct mix_table table;
+    memset(&table, 0, sizeof(table));
+    for (uint32_t i = 0; i < MIX_SLOTS; i++) {
+        table.order[i] = i;
+    }
+
+    uint8_t *base = cfg->isolated ? utils_vmops_get_map_address(args->tid) : NULL;
+
+    LOG_INFO("thread %d ready.\n", args->tid);
+    plat_time_t t_current = vmops_utils_window_begin(args);
+
+    plat_time_t t_end = t_delta == PLAT_TIME_MAX ? PLAT_TIME_MAX : t_current + t_delta;
+    plat_time_t t_start = t_current;
+
+    size_t counter = 0;
+    while (t_current < t_end && counter < nops) {
+        vmops_op_t op = mix_pick(weights, total, &table, &rand);
+
+        /* a map takes the first free slot, all other operations pick a random live mapping */
+        uint32_t idx = table.nlive;
+        if (op != VMOPS_OP_MAP) {
+            idx = vmops_utils_rand(&rand) % table.nlive;
+        }
+
+        uint32_t slot = table.order[idx];
+        uint8_t *addr = table.addr[slot];
+        size_t page = (vmops_utils_rand(&rand) % npages) * pagesize;
+
+        plat_time_t t_op_start = vmops_utils_op_start(&args->stats, t_current);
+
+        switch (op) {
+        case VMOPS_OP_MAP:
+            addr = base != NULL ? base + slot * memsize : NULL;
+            err = plat_vm_map_lazy((void **)&addr, memsize, args->memobj, 0, cfg->pages);
+            break;
+        case VMOPS_OP_UNMAP:
+            err = plat_vm_unmap(addr, memsize);
+            break;
+        case VMOPS_OP_PROTECT:
+            err = plat_vm_protect(addr, memsize,
+                                  table.readonly[slot] ? PLAT_PERM_READ_WRITE
+                                                       : PLAT_PERM_READ_ONLY);
+            break;
+        case VMOPS_OP_FAULT:
+            if (table.readonly[slot]) {
+                (void)*(volatile uint8_t *)(addr + page);
+            } else {
+                *(volatile uint8_t *)(addr + page) = 1;
+            }
+            err = PLAT_ERR_OK;
+            break;
+        default:
+            err = plat_vm_discard(addr, memsize, args->memobj);
+            break;
+        }
+
+        t_current = plat_get_time();
+
+        if (err != PLAT_ERR_OK) {
+            LOG_ERR("thread %d. failed to %s memory ops=%zu!\n", args->tid,
+                    vmops_utils_op_name(op), counter);
+            goto err_out;
+        }
+
+        vmops_utils_add_stats(&args->stats, op, args->tid, counter, t_current - t_start,
+                              t_current - t_op_start);
+
+        if (op == VMOPS_OP_MAP) {
+            table.addr[slot] = addr;
+            table.readonly[slot] = false;
+            table.nlive++;
+        } else if (op == VMOPS_OP_UNMAP) {
+            table.nlive--;
+            table.order[idx] = table.order[table.nlive];
+            table.order[table.nlive] = slot;
+        } else if (op == VMOPS_OP_PROTECT) {
+            table.readonly[slot] = !table.readonly[slot];
+        }
+
+        counter++;
+        vmops_utils_warmup(args, t_current, &counter, &t_start, &t_end);
+    }
+    t_end = plat_get_time();
+
+    args->count = counter;
+    args->duration = plat_time_to_ms(t_end - t_start);
+
+err_out:
+    vmops_utils_window_end(args);
+
+    for (uint32_t i = 0; i < table.nlive; i++) {
+        plat_vm_unmap(table.addr[table.order[i]], memsize);
+    }
+
+    LOG_INFO("thread %d done. ops = %zu, time=%.3f\n", args->tid, counter, args->duration);
+
+    return NULL;
+}
+
+
+/**
+ * @brief starts the mixed operations benchmark
+ *
+ * @param cfg   the benchmark configuration
+ * @param opts  the options for the benchmark
+ *
+ * @returns 0 success, -1 error
+ */
+int vmops_bench_run_mix(struct vmops_bench_cfg *cfg, const char *opts)
+{
+    if (vmops_utils_parse_options(opts, cfg)) {
+        LOG_ERR("failed to parse the options\n");
+        return -1;
+    }
+
+    if (cfg->map4k) {
+        LOG_ERR("the mix benchmark does not support option '4k'\n");
+        return -1;
+    }
+
+    size_t pagesize = plat_page_size(cfg->pages);
+    if (cfg->memsize % pagesize) {
+        LOG_ERR("memsize must be a multiple of the page size %zu\n", pagesize);
+        return -1;
+    }
+
+    if (cfg->isolated && MIX_SLOTS * cfg->memsize > ADDRESS_OFFSET) {
+        LOG_ERR("the isolated mappings of a thread exceed the address region\n");
+        return -1;
+    }
+
+    if (cfg->mix == NULL) {
+        cfg->mix = MIX_DEFAULT;
+    }
+
+    uint32_t weights[VMOPS_OP_MAX];
+    for (uint32_t i = 0; i < cfg->corelist_size; i++) {
+        if (mix_parse(cfg->mix, i, weights)) {
+            LOG_ERR("failed to parse the mix '%s'\n", cfg->mix);
+            return -1;
+        }
+    }
+
+    LOG_INFO("Preparing benchmark. 'mix' with options '%s'\n", vmops_utils_print_options(cfg));
+    LOG_INFO("each operation is picked from the mix '%s' with seed %" PRIu64 "\n", cfg->mix,
+             cfg->seed);
+
+    struct vmops_bench_run_arg *args;
+    if (vmops_utils_prepare_args(cfg, NULL, &args)) {
+        LOG_ERR("failed to prepare arguments\n");
+        return -1;
+    }
+
+    if (vmops_utils_run_benchmark(cfg->corelist_size, args, bench_run_fn)) {
+        LOG_ERR("failed to run the benchmark\n");
+        return -1;
+    }
+
+    vmops_utils_print_csv(args);
+
+    /* the share and the throughput of each operation type that has been executed */
+    size_t total = 0;
+    for (uint32_t i = 0; i < cfg->corelist_size; i++) {
+        total += args[i].count;
+    }
+
+    for (uint32_t j = 0; j < MIX_OPS_MAX; j++) {
+        vmops_op_t op = mix_ops[j];
+
+        size_t count = 0;
+        double thpt = 0;
+        for (uint32_t i = 0; i < cfg->corelist_size; i++) {
+            count += args[i].stats.hist[op].count;
+            if (args[i].duration > 0) {
+                thpt += args[i].stats.hist[op].count * 1000.0 / args[i].duration;
+            }
+        }
+
+        if (count != 0) {
+            LOG_RESULT_MIX(cfg->benchmark, vmops_utils_op_name(op), count,
+                           100.0 * count / total, thpt);
+        }
+    }
+
+    vmops_utils_cleanup_args(args);
+
+    return 0;
+}
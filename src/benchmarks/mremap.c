@@ -0,0 +1,243 @@
+/*
+ * Virtual Memory Operations Benchmark
+ *
+ * Copyright 2020 Reto Achermann
+ * SPDX-License-Identifier: GPL-3.0
+ */
+
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "benchmarks.h"
+#include "utils.h"
+
+
+static void *bench_run_grow_fn(struct vmops_bench_run_arg *args)
+{
+    plat_error_t err;
+
+    struct vmops_bench_cfg *cfg = args->cfg;
+
+    plat_time_t t_delta = plat_convert_time(args->cfg->time_ms);
+    if (t_delta == 0) {
+        t_delta = PLAT_TIME_MAX;
+    }
+
+    size_t nops = cfg->nops;
+    if (nops == 0) {
+        nops = SIZE_MAX;
+    }
+
+    size_t memsize = cfg->memsize;
+
+    void *addr;
+    if (cfg->isolated) {
+        addr = utils_vmops_get_map_address(args->tid);
+        err = plat_vm_map_fixed(addr, memsize, args->memobj, 0, cfg->pages);
+    } else {
+        err = plat_vm_map(&addr, memsize, args->memobj, 0, cfg->pages);
+    }
+
+    if (err != PLAT_ERR_OK) {
+        LOG_ERR("thread %d failed to map memory. exiting.\n", args->tid);
+        return NULL;
+    }
+
+    LOG_INFO("thread %d ready.\n", args->tid);
+    plat_time_t t_current = vmops_utils_window_begin(args);
+
+    plat_time_t t_end = t_delta == PLAT_TIME_MAX ? PLAT_TIME_MAX : t_current + t_delta;
+    plat_time_t t_start = t_current;
+
+    /* shrinking unmaps the upper half of the mapping, growing extends it in place again */
+    size_t counter = 0;
+    while (t_current < t_end && counter < nops) {
+        plat_time_t t_op_start = vmops_utils_op_start(&args->stats, t_current);
+
+        void *new_addr = NULL;
+        err = plat_vm_remap(addr, memsize, &new_addr, memsize / 2, PLAT_REMAP_RESIZE);
+        if (err != PLAT_ERR_OK) {
+            LOG_ERR("thread %d. failed to shrink the mapping ops=%zu!\n", args->tid, counter);
+            goto err_out;
+        }
+
+        plat_time_t t_shrink_end = plat_get_time();
+
+        err = plat_vm_remap(addr, memsize / 2, &new_addr, memsize, PLAT_REMAP_RESIZE);
+        if (err != PLAT_ERR_OK) {
+            LOG_ERR("thread %d. failed to grow the mapping ops=%zu!\n", args->tid, counter);
+            goto err_out;
+        }
+
+        t_current = plat_get_time();
+
+        vmops_utils_add_stats(&args->stats, VMOPS_OP_UNMAP, args->tid, counter,
+                              t_shrink_end - t_start, t_shrink_end - t_op_start);
+        vmops_utils_add_stats(&args->stats, VMOPS_OP_REMAP, args->tid, counter,
+                              t_current - t_start, t_current - t_shrink_end);
+
+        counter++;
+        vmops_utils_warmup(args, t_current, &counter, &t_start, &t_end);
+    }
+    t_end = plat_get_time();
+
+    args->count = counter;
+    args->duration = plat_time_to_ms(t_end - t_start);
+
+err_out:
+    vmops_utils_window_end(args);
+
+    plat_vm_unmap(addr, memsize);
+
+    LOG_INFO("thread %d done. ops = %zu, time=%.3f\n", args->tid, counter, args->duration);
+
+    return NULL;
+}
+
+
+static void *bench_run_move_fn(struct vmops_bench_run_arg *args)
+{
+    plat_error_t err;
+
+    struct vmops_bench_cfg *cfg = args->cfg;
+
+    plat_time_t t_delta = plat_convert_time(args->cfg->time_ms);
+    if (t_delta == 0) {
+        t_delta = PLAT_TIME_MAX;
+    }
+
+    size_t nops = cfg->nops;
+    if (nops == 0) {
+        nops = SIZE_MAX;
+    }
+
+    size_t memsize = cfg->memsize;
+
+    void *addr;
+    if (cfg->isolated) {
+        addr = utils_vmops_get_map_address(args->tid);
+        err = plat_vm_map_fixed(addr, memsize, args->memobj, 0, cfg->pages);
+    } else {
+        err = plat_vm_map(&addr, memsize, args->memobj, 0, cfg->pages);
+    }
+
+    if (err != PLAT_ERR_OK) {
+        LOG_ERR("thread %d failed to map memory. exiting.\n", args->tid);
+        return NULL;
+    }
+
+    /* the second address is reserved by a mapping that the first move replaces */
+    void *other = cfg->isolated ? (void *)((uintptr_t)addr + memsize) : NULL;
+    err = plat_vm_map_lazy(&other, memsize, args->memobj, 0, cfg->pages);
+    if (err != PLAT_ERR_OK) {
+        LOG_ERR("thread %d failed to reserve the target address. exiting.\n", args->tid);
+        plat_vm_unmap(addr, memsize);
+        return NULL;
+    }
+
+    LOG_INFO("thread %d ready.\n", args->tid);
+    plat_time_t t_current = vmops_utils_window_begin(args);
+
+    plat_time_t t_end = t_delta == PLAT_TIME_MAX ? PLAT_TIME_MAX : t_current + t_delta;
+    plat_time_t t_start = t_current;
+
+    /* the mapping moves back and forth between the two addresses */
+    size_t counter = 0;
+    while (t_current < t_end && counter < nops) {
+        plat_time_t t_op_start = vmops_utils_op_start(&args->stats, t_current);
+
+        void *new_addr = other;
+        err = plat_vm_remap(addr, memsize, &new_addr, memsize, cfg->remap);
+        if (err != PLAT_ERR_OK) {
+            LOG_ERR("thread %d. failed to move the mapping ops=%zu!\n", args->tid, counter);
+            goto err_out;
+        }
+
+        t_current = plat_get_time();
+
+        vmops_utils_add_stats(&args->stats, VMOPS_OP_REMAP, args->tid, counter,
+                              t_current - t_start, t_current - t_op_start);
+
+        other = addr;
+        addr = new_addr;
+
+        counter++;
+        vmops_utils_warmup(args, t_current, &counter, &t_start, &t_end);
+    }
+    t_end = plat_get_time();
+
+    args->count = counter;
+    args->duration = plat_time_to_ms(t_end - t_start);
+
+err_out:
+    vmops_utils_window_end(args);
+
+    plat_vm_unmap(addr, memsize);
+    plat_vm_unmap(other, memsize);
+
+    LOG_INFO("thread %d done. ops = %zu, time=%.3f\n", args->tid, counter, args->duration);
+
+    return NULL;
+}
+
+
+/**
+ * @brief starts the mremap benchmark
+ *
+ * @param cfg   the benchmark configuration
+ * @param opts  the options for the benchmark
+ *
+ * @returns 0 success, -1 error
+ */
+int vmops_bench_run_mremap(struct vmops_bench_cfg *cfg, const char *opts)
+{
+    if (vmops_utils_parse_options(opts, cfg)) {
+        LOG_ERR("failed to parse the options\n");
+        return -1;
+    }
+
+    if (cfg->map4k) {
+        LOG_ERR("the mremap benchmark does not support option '4k'\n");
+        return -1;
+    }
+
+    /* the grow variant shrinks the mapping to half of its size */
+    size_t pagesize = plat_page_size(cfg->pages);
+    size_t granule = cfg->remap == PLAT_REMAP_RESIZE ? 2 * pagesize : pagesize;
+    if (cfg->memsize % granule) {
+        LOG_ERR("memsize must be a multiple of %zu\n", granule);
+        return -1;
+    }
+
+    if (cfg->isolated && cfg->remap != PLAT_REMAP_RESIZE && 2 * cfg->memsize > ADDRESS_OFFSET) {
+        LOG_ERR("the isolated mappings and their targets exceed the address region\n");
+        return -1;
+    }
+
+    LOG_INFO("Preparing benchmark. 'mremap' with options '%s'\n",
+             vmops_utils_print_options(cfg));
+
+    struct vmops_bench_run_arg *args;
+    if (vmops_utils_prepare_args(cfg, NULL, &args)) {
+        LOG_ERR("failed to prepare arguments\n");
+        return -1;
+    }
+
+    plat_thread_fn_t run_fn = bench_run_move_fn;
+    if (cfg->remap == PLAT_REMAP_RESIZE) {
+        run_fn = bench_run_grow_fn;
+    }
+
+    if (vmops_utils_run_benchmark(cfg->corelist_size, args, run_fn)) {
+        LOG_ERR("failed to run the benchmark\n");
+        return -1;
+    }
+
+    vmops_utils_print_csv(args);
+
+    vmops_utils_cleanup_args(args);
+
+    return 0;
+}
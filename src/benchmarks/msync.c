@@ -0,0 +1,177 @@
+/*
+ * Virtual Memory Operations Benchmark
+ *
+ * Copyright 2020 Reto Achermann
+ * SPDX-License-Identifier: GPL-3.0
+ */
+
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "benchmarks.h"
+#include "utils.h"
+
+
+static void *bench_run_fn(struct vmops_bench_run_arg *args)
+{
+    plat_error_t err;
+
+    struct vmops_bench_cfg *cfg = args->cfg;
+
+    plat_time_t t_delta = plat_convert_time(args->cfg->time_ms);
+    if (t_delta == 0) {
+        t_delta = PLAT_TIME_MAX;
+    }
+
+    size_t nops = cfg->nops;
+    if (nops == 0) {
+        nops = SIZE_MAX;
+    }
+
+    size_t pagesize = plat_page_size(cfg->pages);
+
+    /* with a shared memory object, each thread maps and writes back its own slice of it */
+    size_t offset = 0;
+    size_t size = cfg->memsize;
+    if (cfg->shared) {
+        size_t npages = cfg->memsize / pagesize;
+        size_t first = npages * args->tid / cfg->corelist_size;
+        size_t last = npages * (args->tid + 1) / cfg->corelist_size;
+        offset = first * pagesize;
+        size = (last - first) * pagesize;
+    }
+
+    void *addr;
+    if (cfg->isolated) {
+        addr = utils_vmops_get_map_address(args->tid);
+        err = plat_vm_map_fixed(addr, size, args->memobj, offset, cfg->pages);
+    } else {
+        err = plat_vm_map(&addr, size, args->memobj, offset, cfg->pages);
+    }
+
+    if (err != PLAT_ERR_OK) {
+        LOG_ERR("thread %d failed to map memory. exiting.\n", args->tid);
+        return NULL;
+    }
+
+    volatile uint8_t *pages = (volatile uint8_t *)addr;
+    size_t npages = size / pagesize;
+
+    LOG_INFO("thread %d ready.\n", args->tid);
+    plat_time_t t_current = vmops_utils_window_begin(args);
+
+    plat_time_t t_end = t_delta == PLAT_TIME_MAX ? PLAT_TIME_MAX : t_current + t_delta;
+    plat_time_t t_start = t_current;
+
+    /* the operations are the pages written back */
+    size_t counter = 0;
+    while (t_current < t_end && counter < nops) {
+        plat_time_t t_op_start = vmops_utils_op_start(&args->stats, t_current);
+        for (size_t i = 0; i < size; i += pagesize) {
+            pages[i]++;
+        }
+
+        plat_time_t t_dirty_end = plat_get_time();
+
+        err = plat_vm_sync(addr, size);
+        if (err != PLAT_ERR_OK) {
+            LOG_ERR("thread %d. failed to write back the memory!\n", args->tid);
+            goto err_out;
+        }
+
+        t_current = plat_get_time();
+
+        vmops_utils_add_stats(&args->stats, VMOPS_OP_DIRTY, args->tid, counter,
+                              t_dirty_end - t_start, t_dirty_end - t_op_start);
+        vmops_utils_add_stats(&args->stats, VMOPS_OP_SYNC, args->tid, counter,
+                              t_current - t_start, t_current - t_dirty_end);
+
+        counter += npages;
+        vmops_utils_warmup(args, t_current, &counter, &t_start, &t_end);
+    }
+    t_end = plat_get_time();
+
+    args->count = counter;
+    args->duration = plat_time_to_ms(t_end - t_start);
+
+err_out:
+    vmops_utils_window_end(args);
+
+    plat_vm_unmap(addr, size);
+
+    LOG_INFO("thread %d done. ops = %zu, time=%.3f\n", args->tid, counter, args->duration);
+
+    return NULL;
+}
+
+
+/**
+ * @brief starts the msync benchmark
+ *
+ * @param cfg   the benchmark configuration
+ * @param opts  the options for the benchmark
+ *
+ * @returns 0 success, -1 error
+ */
+int vmops_bench_run_msync(struct vmops_bench_cfg *cfg, const char *opts)
+{
+    if (vmops_utils_parse_options(opts, cfg)) {
+        LOG_ERR("failed to parse the options\n");
+        return -1;
+    }
+
+    if (cfg->map4k) {
+        LOG_ERR("the msync benchmark does not support option '4k'\n");
+        return -1;
+    }
+
+    size_t pagesize = plat_page_size(cfg->pages);
+    if (cfg->memsize % pagesize) {
+        LOG_ERR("memsize must be a multiple of the page size %zu\n", pagesize);
+        return -1;
+    }
+
+    if (cfg->shared && cfg->memsize / pagesize < cfg->corelist_size) {
+        LOG_ERR("the shared memory object needs at least one page per thread. memsize=%zu\n",
+                cfg->memsize);
+        return -1;
+    }
+
+    LOG_INFO("Preparing benchmark. 'msync' with options '%s'\n", vmops_utils_print_options(cfg));
+    LOG_INFO("each operation is a page that is dirtied and written back\n");
+
+    struct vmops_bench_run_arg *args;
+    if (vmops_utils_prepare_args(cfg, NULL, &args)) {
+        LOG_ERR("failed to prepare arguments\n");
+        return -1;
+    }
+
+    if (vmops_utils_run_benchmark(cfg->corelist_size, args, bench_run_fn)) {
+        LOG_ERR("failed to run the benchmark\n");
+        return -1;
+    }
+
+    vmops_utils_print_csv(args);
+
+    /* the cost per page, the histograms hold the time of dirtying and writing back all pages */
+    size_t pages = 0;
+    uint64_t t_dirty = 0;
+    uint64_t t_sync = 0;
+    double thpt = 0;
+    for (uint32_t i = 0; i < cfg->corelist_size; i++) {
+        pages += args[i].count;
+        t_dirty += args[i].stats.hist[VMOPS_OP_DIRTY].sum;
+        t_sync += args[i].stats.hist[VMOPS_OP_SYNC].sum;
+        thpt += args[i].duration > 0 ? args[i].count * 1000.0 / args[i].duration : 0;
+    }
+
+    double dirty_per_page = pages ? plat_time_to_ms(t_dirty) / pages : 0;
+    double sync_per_page = pages ? plat_time_to_ms(t_sync) / pages : 0;
+    LOG_RESULT_SYNC(cfg->benchmark, pages, dirty_per_page, sync_per_page, thpt);
+
+    vmops_utils_cleanup_args(args);
+
+    return 0;
+}
@@ -35,9 +35,9 @@ static void *bench_run_fn(struct vmops_bench_run_arg *args)
     void *addr;
     if (cfg->isolated) {
         addr = utils_vmops_get_map_address(args->tid);
-        err = plat_vm_map_fixed(addr, cfg->memsize, args->memobj, 0, cfg->maphuge);
+        err = plat_vm_map_fixed(addr, cfg->memsize, args->memobj, 0, cfg->pages);
     } else {
-        err = plat_vm_map(&addr, cfg->memsize, args->memobj, 0, cfg->maphuge);
+        err = plat_vm_map(&addr, cfg->memsize, args->memobj, 0, cfg->pages);
     }
 
     if (err != PLAT_ERR_OK) {
@@ -46,15 +46,14 @@ static void *bench_run_fn(struct vmops_bench_run_arg *args)
     }
 
     LOG_INFO("thread %d ready.\n", args->tid);
-    plat_thread_barrier(args->barrier);
-
+    plat_time_t t_current = vmops_utils_window_begin(args);
 
-    plat_time_t t_current = plat_get_time();
     plat_time_t t_end = t_delta == PLAT_TIME_MAX ? PLAT_TIME_MAX : t_current + t_delta;
     plat_time_t t_start = t_current;
 
     size_t counter = 0;
     while (t_current < t_end && counter < nops) {
+        plat_time_t t_op_start = vmops_utils_op_start(&args->stats, t_current);
         err = plat_vm_protect(addr, cfg->memsize, PLAT_PERM_READ_ONLY);
         if (err != PLAT_ERR_OK) {
             LOG_ERR("thread %d. failed to protect memory!\n", args->tid);
@@ -66,21 +65,143 @@ static void *bench_run_fn(struct vmops_bench_run_arg *args)
             goto err_out;
         }
         t_current = plat_get_time();
+
+        vmops_utils_add_stats(&args->stats, VMOPS_OP_PROTECT, args->tid, counter,
+                              t_current - t_start, t_current - t_op_start);
+
         counter++;
+        vmops_utils_warmup(args, t_current, &counter, &t_start, &t_end);
     }
     t_end = plat_get_time();
 
-    plat_thread_barrier(args->barrier);
-
     args->count = counter;
     args->duration = plat_time_to_ms(t_end - t_start);
 
+err_out:
+    vmops_utils_window_end(args);
+
+    plat_vm_unmap(addr, cfg->memsize);
+
     LOG_INFO("thread %d done. ops = %zu, time=%.3f\n", args->tid, counter, args->duration);
 
     return NULL;
+}
+
+
+static void *bench_run_split_fn(struct vmops_bench_run_arg *args)
+{
+    plat_error_t err;
+
+    struct vmops_bench_cfg *cfg = args->cfg;
+
+    plat_time_t t_delta = plat_convert_time(args->cfg->time_ms);
+    if (t_delta == 0) {
+        t_delta = PLAT_TIME_MAX;
+    }
+
+    size_t nops = cfg->nops;
+    if (nops == 0) {
+        nops = SIZE_MAX;
+    }
+
+    void *addr;
+    if (cfg->isolated) {
+        addr = utils_vmops_get_map_address(args->tid);
+        err = plat_vm_map_fixed(addr, cfg->memsize, args->memobj, 0, cfg->pages);
+    } else {
+        err = plat_vm_map(&addr, cfg->memsize, args->memobj, 0, cfg->pages);
+    }
+
+    if (err != PLAT_ERR_OK) {
+        LOG_ERR("thread %d failed to map memory. exiting.\n", args->tid);
+        return NULL;
+    }
+
+    size_t pagesize = plat_page_size(cfg->pages);
+    size_t npages = cfg->memsize / pagesize;
+
+    /* a round protects the pages one by one, then unprotects them in the same order */
+    size_t stride = cfg->split_stride;
+    size_t nsplits = cfg->split == VMOPS_SPLIT_RANDOM ? 1 : (npages + stride - 1) / stride;
+    uint64_t seed = args->tid + 1;
+
+    LOG_INFO("thread %d ready.\n", args->tid);
+    plat_time_t t_current = vmops_utils_window_begin(args);
+
+    plat_time_t t_end = t_delta == PLAT_TIME_MAX ? PLAT_TIME_MAX : t_current + t_delta;
+    plat_time_t t_start = t_current;
+
+    size_t counter = 0;
+    size_t idx = 0;
+    size_t page = 0;
+    bool merging = false;
+    while (t_current < t_end && counter < nops) {
+        if (!merging) {
+            page = cfg->split == VMOPS_SPLIT_RANDOM ? vmops_utils_rand(&seed) % npages
+                                                    : idx * stride;
+        }
+
+        void *range = (void *)((uintptr_t)addr + page * pagesize);
+
+        plat_time_t t_op_start = vmops_utils_op_start(&args->stats, t_current);
+        if (merging) {
+            err = plat_vm_protect(range, pagesize, PLAT_PERM_READ_WRITE);
+        } else {
+            err = plat_vm_protect(range, pagesize, PLAT_PERM_READ_ONLY);
+        }
+        if (err != PLAT_ERR_OK) {
+            LOG_ERR("thread %d. failed to %s the mapping at page %zu!\n", args->tid,
+                    merging ? "merge" : "split", page);
+            goto err_out;
+        }
+        t_current = plat_get_time();
+
+        vmops_utils_add_stats(&args->stats, merging ? VMOPS_OP_MERGE : VMOPS_OP_SPLIT, args->tid,
+                              counter, t_current - t_start, t_current - t_op_start);
+
+        counter++;
+
+        if (++idx == nsplits) {
+            merging = !merging;
+            idx = 0;
+        }
+
+        vmops_utils_warmup(args, t_current, &counter, &t_start, &t_end);
+    }
+    t_end = plat_get_time();
+
+    args->count = counter;
+    args->duration = plat_time_to_ms(t_end - t_start);
 
 err_out:
+    vmops_utils_window_end(args);
+
+    /*
+     * the mappings are counted outside of the window, with the mapping of each thread split
+     * like after the first round. the barriers keep the other threads from changing theirs.
+     */
+    if (args->vmas == 0) {
+        plat_vm_protect(addr, cfg->memsize, PLAT_PERM_READ_WRITE);
+        for (idx = 0; idx < nsplits; idx++) {
+            page = cfg->split == VMOPS_SPLIT_RANDOM ? vmops_utils_rand(&seed) % npages
+                                                    : idx * stride;
+            plat_vm_protect((void *)((uintptr_t)addr + page * pagesize), pagesize,
+                            PLAT_PERM_READ_ONLY);
+        }
+    }
+
+    plat_thread_barrier(args->barrier);
+
+    if (args->vmas == 0) {
+        plat_vm_count_mappings(&args->vmas);
+    }
+
+    plat_thread_barrier(args->barrier);
+
     plat_vm_unmap(addr, cfg->memsize);
+
+    LOG_INFO("thread %d done. ops = %zu, time=%.3f\n", args->tid, counter, args->duration);
+
     return NULL;
 }
 
@@ -102,7 +223,8 @@ static void *bench_run_4k_fn(struct vmops_bench_run_arg *args)
         nops = SIZE_MAX;
     }
 
-    size_t nmaps = cfg->memsize / PLAT_ARCH_BASE_PAGE_SIZE;
+    size_t pagesize = plat_page_size(cfg->pages);
+    size_t nmaps = cfg->memsize / pagesize;
     void **addrs = calloc(nmaps, sizeof(void *));
     if (addrs == NULL) {
         LOG_ERR("thread %d malloc failed!\n", args->tid);
@@ -112,20 +234,18 @@ static void *bench_run_4k_fn(struct vmops_bench_run_arg *args)
     if (cfg->isolated) {
         void *addr = utils_vmops_get_map_address(args->tid);
         for (size_t i = 0; i < nmaps; i++) {
-            err = plat_vm_map_fixed(addr, PLAT_ARCH_BASE_PAGE_SIZE, args->memobj,
-                                    i * PLAT_ARCH_BASE_PAGE_SIZE, cfg->maphuge);
+            err = plat_vm_map_fixed(addr, pagesize, args->memobj, i * pagesize, cfg->pages);
             if (err != PLAT_ERR_OK) {
                 LOG_ERR("thread %d. failed to map memory!\n", args->tid);
                 goto cleanup_and_exit;
             }
             addrs[i] = addr;
 
-            addr = (void *)((uintptr_t)addr + PLAT_ARCH_BASE_PAGE_SIZE);
+            addr = (void *)((uintptr_t)addr + pagesize);
         }
     } else {
         for (size_t i = 0; i < nmaps; i++) {
-            err = plat_vm_map(&addrs[i], PLAT_ARCH_BASE_PAGE_SIZE, args->memobj,
-                              i * PLAT_ARCH_BASE_PAGE_SIZE, cfg->maphuge);
+            err = plat_vm_map(&addrs[i], pagesize, args->memobj, i * pagesize, cfg->pages);
             if (err != PLAT_ERR_OK) {
                 LOG_ERR("thread %d. failed to map memory!\n", args->tid);
                 goto cleanup_and_exit;
@@ -134,28 +254,33 @@ static void *bench_run_4k_fn(struct vmops_bench_run_arg *args)
     }
 
     LOG_INFO("thread %d ready.\n", args->tid);
-    plat_thread_barrier(args->barrier);
+    plat_time_t t_current = vmops_utils_window_begin(args);
 
-    plat_time_t t_current = plat_get_time();
     plat_time_t t_end = t_delta == PLAT_TIME_MAX ? PLAT_TIME_MAX : t_current + t_delta;
     plat_time_t t_start = t_current;
 
     size_t page = args->tid;
 
     while (t_current < t_end && counter < nops) {
+        plat_time_t t_op_start = vmops_utils_op_start(&args->stats, t_current);
         size_t idx = (page++) % nmaps;
-        err = plat_vm_protect(addrs[idx], PLAT_ARCH_BASE_PAGE_SIZE, PLAT_PERM_READ_ONLY);
+        err = plat_vm_protect(addrs[idx], pagesize, PLAT_PERM_READ_ONLY);
         if (err != PLAT_ERR_OK) {
             LOG_ERR("thread %d. failed to protect memory!\n", args->tid);
             goto cleanup_and_exit;
         }
-        err = plat_vm_protect(addrs[idx], PLAT_ARCH_BASE_PAGE_SIZE, PLAT_PERM_READ_WRITE);
+        err = plat_vm_protect(addrs[idx], pagesize, PLAT_PERM_READ_WRITE);
         if (err != PLAT_ERR_OK) {
             LOG_ERR("thread %d. failed to unprotect memory!\n", args->tid);
             goto cleanup_and_exit;
         }
         t_current = plat_get_time();
+
+        vmops_utils_add_stats(&args->stats, VMOPS_OP_PROTECT, args->tid, counter,
+                              t_current - t_start, t_current - t_op_start);
+
         counter++;
+        vmops_utils_warmup(args, t_current, &counter, &t_start, &t_end);
     }
     t_end = plat_get_time();
 
@@ -164,11 +289,11 @@ static void *bench_run_4k_fn(struct vmops_bench_run_arg *args)
 
 cleanup_and_exit:
 
-    plat_thread_barrier(args->barrier);
+    vmops_utils_window_end(args);
 
     for (size_t i = 0; i < nmaps; i++) {
         if (addrs[i] != NULL) {
-            err = plat_vm_unmap(addrs[i], PLAT_ARCH_BASE_PAGE_SIZE);
+            err = plat_vm_unmap(addrs[i], pagesize);
             if (err != PLAT_ERR_OK) {
                 LOG_ERR("thread %d. failed to unmap memory!\n", args->tid);
             }
@@ -200,8 +325,27 @@ int vmops_bench_run_protect(struct vmops_bench_cfg *cfg, const char *opts)
         return -1;
     }
 
+    size_t npages = cfg->memsize / plat_page_size(cfg->pages);
+    if (cfg->split != VMOPS_SPLIT_NONE) {
+        if (cfg->map4k) {
+            LOG_ERR("the split variants do not support option '4k'\n");
+            return -1;
+        }
+
+        /* the protected pages must leave unprotected pages between them */
+        if (npages < 2 || (cfg->split == VMOPS_SPLIT_STRIDE && cfg->split_stride < 2)) {
+            LOG_ERR("the split variants need a stride of at least 2 and at least 2 pages\n");
+            return -1;
+        }
+    }
 
     LOG_INFO("Preparing benchmark. 'protect' with options '%s'\n", vmops_utils_print_options(cfg));
+    if (cfg->split == VMOPS_SPLIT_STRIDE) {
+        LOG_INFO("each operation splits or merges the mapping at every %u-th page\n",
+                 cfg->split_stride);
+    } else if (cfg->split == VMOPS_SPLIT_RANDOM) {
+        LOG_INFO("each operation splits or merges the mapping at a random page\n");
+    }
 
     struct vmops_bench_run_arg *args;
     if (vmops_utils_prepare_args(cfg, NULL, &args)) {
@@ -209,10 +353,16 @@ int vmops_bench_run_protect(struct vmops_bench_cfg *cfg, const char *opts)
         return -1;
     }
 
+    /* the mappings of the process without the ones of the benchmark threads */
+    size_t vmas_before = 0;
+    plat_vm_count_mappings(&vmas_before);
+
     plat_thread_fn_t run_fn = bench_run_fn;
 
     if (cfg->map4k) {
         run_fn = bench_run_4k_fn;
+    } else if (cfg->split != VMOPS_SPLIT_NONE) {
+        run_fn = bench_run_split_fn;
     }
 
     if (vmops_utils_run_benchmark(cfg->corelist_size, args, run_fn)) {
@@ -222,6 +372,16 @@ int vmops_bench_run_protect(struct vmops_bench_cfg *cfg, const char *opts)
 
     vmops_utils_print_csv(args);
 
+    if (cfg->split != VMOPS_SPLIT_NONE) {
+        /* the threads share the address space, the largest count includes all their splits */
+        size_t vmas = 0;
+        for (uint32_t i = 0; i < cfg->corelist_size; i++) {
+            vmas = args[i].vmas > vmas ? args[i].vmas : vmas;
+        }
+        uint32_t stride = cfg->split == VMOPS_SPLIT_STRIDE ? cfg->split_stride : 0;
+        LOG_RESULT_SPLIT(cfg->benchmark, npages, stride, vmas_before, vmas);
+    }
+
     vmops_utils_cleanup_args(args);
 
     return 0;
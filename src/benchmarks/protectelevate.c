@@ -34,7 +34,16 @@ static void *bench_run_fn(struct vmops_bench_run_arg *args)
         nops = DEFAULT_NOPS;
     }
 
-    size_t total_map_size = (nops * PLAT_ARCH_BASE_PAGE_SIZE);
+    size_t pagesize = plat_page_size(cfg->pages);
+    size_t total_map_size = (nops * pagesize);
+
+    /* the mappings are unmapped once the window has ended */
+    size_t nmaps = (total_map_size + cfg->memsize - 1) / cfg->memsize;
+    void **maps = calloc(nmaps, sizeof(void *));
+    if (maps == NULL) {
+        LOG_ERR("thread %d malloc failed!\n", args->tid);
+        return NULL;
+    }
 
     void *addr = utils_vmops_get_map_address(args->tid);
     if (!cfg->isolated) {
@@ -42,13 +51,13 @@ static void *bench_run_fn(struct vmops_bench_run_arg *args)
     }
 
     for (size_t i = 0; i < total_map_size; i += cfg->memsize) {
+        void *curaddr;
         if (cfg->isolated) {
-            void *curaddr = ((char *)addr + i);
-            err = plat_vm_map_fixed(curaddr, cfg->memsize, args->memobj, 0, 0);
+            curaddr = ((char *)addr + i);
+            err = plat_vm_map_fixed(curaddr, cfg->memsize, args->memobj, 0, cfg->pages);
         } else {
-            void *curaddr;
-            err = plat_vm_map(&curaddr, cfg->memsize, args->memobj, 0, 0);
-            if (addr == NULL) {
+            err = plat_vm_map(&curaddr, cfg->memsize, args->memobj, 0, cfg->pages);
+            if (err == PLAT_ERR_OK && addr == NULL) {
                 addr = curaddr;
             }
         }
@@ -56,9 +65,15 @@ static void *bench_run_fn(struct vmops_bench_run_arg *args)
         if (err != PLAT_ERR_OK) {
             LOG_ERR("thread %d failed to map memory %zu / %zu kB. exiting.\n", args->tid, i >> 10,
                     total_map_size >> 10);
+            for (size_t j = 0; j < i / cfg->memsize; j++) {
+                plat_vm_unmap(maps[j], cfg->memsize);
+            }
+            free(maps);
             return NULL;
         }
 
+        maps[i / cfg->memsize] = curaddr;
+
         err = plat_vm_protect(addr, cfg->memsize, PLAT_PERM_READ_ONLY);
         if (err != PLAT_ERR_OK) {
             LOG_ERR("thread %d failed to protect memory. exiting.\n", args->tid);
@@ -67,40 +82,46 @@ static void *bench_run_fn(struct vmops_bench_run_arg *args)
 
 
     LOG_INFO("thread %d ready.\n", args->tid);
-    plat_thread_barrier(args->barrier);
+    plat_time_t t_current = vmops_utils_window_begin(args);
 
-    plat_time_t t_current = plat_get_time();
     plat_time_t t_end = t_delta == PLAT_TIME_MAX ? PLAT_TIME_MAX : t_current + t_delta;
     plat_time_t t_start = t_current;
     size_t counter = 0;
 
-    while (t_current < t_end && counter < nops) {
-        plat_time_t t_op_start = t_current;
-        err = plat_vm_protect(addr, PLAT_ARCH_BASE_PAGE_SIZE, PLAT_PERM_READ_WRITE);
+    /* the prepared pages run out after nops operations, also those during the warmup */
+    size_t page = 0;
+    while (t_current < t_end && counter < nops && page < nops) {
+        plat_time_t t_op_start = vmops_utils_op_start(&args->stats, t_current);
+        err = plat_vm_protect(addr, pagesize, PLAT_PERM_READ_WRITE);
         if (err != PLAT_ERR_OK) {
             LOG_ERR("thread %d. failed to unprotect memory!\n", args->tid);
             goto err_out;
         }
         t_current = plat_get_time();
         counter++;
-        addr = ((char *)addr + PLAT_ARCH_BASE_PAGE_SIZE);
+        page++;
+        addr = ((char *)addr + pagesize);
 
-        vmops_utils_add_stats(&args->stats, args->tid, counter, t_current - t_start,
-                        t_current - t_op_start);
+        vmops_utils_add_stats(&args->stats, VMOPS_OP_PROTECT, args->tid, counter,
+                              t_current - t_start, t_current - t_op_start);
+        vmops_utils_warmup(args, t_current, &counter, &t_start, &t_end);
     }
     t_end = plat_get_time();
 
-    plat_thread_barrier(args->barrier);
-
     args->count = counter;
     args->duration = plat_time_to_ms(t_end - t_start);
 
-    LOG_INFO("thread %d done. ops = %zu, time=%.3f\n", args->tid, counter, args->duration);
+err_out:
+    vmops_utils_window_end(args);
 
-    return NULL;
+    for (size_t i = 0; i < nmaps; i++) {
+        plat_vm_unmap(maps[i], cfg->memsize);
+    }
+
+    free(maps);
+
+    LOG_INFO("thread %d done. ops = %zu, time=%.3f\n", args->tid, counter, args->duration);
 
-err_out:
-    plat_vm_unmap(addr, cfg->memsize);
     return NULL;
 }
 
@@ -0,0 +1,449 @@
+/*
+ * Virtual Memory Operations Benchmark
+ *
+ * Copyright 2020 Reto Achermann
+ * SPDX-License-Identifier: GPL-3.0
+ */
+
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "benchmarks.h"
+#include "replay.h"
+#include "utils.h"
+
+///< the loaded replay trace, shared by all benchmark threads
+struct replay_trace
+{
+    struct vmops_replay_header hdr;       ///< the header of the trace file
+    struct vmops_replay_record *records;  ///< the validated operation records
+    size_t maxsize;                       ///< the size of the largest mapping
+    size_t *passes;                       ///< the completed passes of each thread
+    plat_time_t *lag;                     ///< the largest lag behind the recording of each thread
+};
+
+///< the mapping that an address slot is remapped to
+struct replay_slot
+{
+    uint8_t *addr;  ///< the address of the mapping, NULL if the slot is not mapped
+    size_t size;    ///< the size of the mapping
+    size_t idx;     ///< the record that mapped the slot
+};
+
+///< a range of an address slot that has been unmapped
+struct replay_range
+{
+    uint32_t slot;  ///< the address slot
+    size_t start;   ///< the start of the range relative to the mapping
+    size_t end;     ///< the end of the range relative to the mapping
+};
+
+
+/**
+ * @brief loads and validates a replay trace
+ *
+ * @param path      the path of the trace file
+ * @param pagesize  the size of the pages the trace is replayed with
+ * @param trace     returns the loaded trace
+ *
+ * @returns 0 on success, -1 on failure
+ *
+ * The sizes of the records are rounded up to the page size. The records must map a slot before
+ * they unmap or protect ranges of it. A slot can be mapped again once it has been unmapped with
+ * a single record that covers all of its mapping.
+ */
+static int replay_load(const char *path, size_t pagesize, struct replay_trace *trace)
+{
+    struct vmops_replay_header *hdr = &trace->hdr;
+    size_t *mapped = NULL;
+
+    memset(trace, 0, sizeof(*trace));
+
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        LOG_ERR("could not open replay trace '%s'\n", path);
+        return -1;
+    }
+
+    if (fread(hdr, sizeof(*hdr), 1, f) != 1 || memcmp(hdr->magic, VMOPS_REPLAY_MAGIC, 8) != 0) {
+        LOG_ERR("'%s' is not a replay trace\n", path);
+        goto err_out;
+    }
+
+    if (hdr->version != VMOPS_REPLAY_VERSION
+        || hdr->record_size != sizeof(struct vmops_replay_record)) {
+        LOG_ERR("unsupported replay trace version %u\n", hdr->version);
+        goto err_out;
+    }
+
+    if (hdr->nrecords == 0 || hdr->nslots == 0) {
+        LOG_ERR("the replay trace '%s' is empty\n", path);
+        goto err_out;
+    }
+
+    trace->records = malloc(hdr->nrecords * sizeof(struct vmops_replay_record));
+    mapped = calloc(hdr->nslots, sizeof(size_t));
+    if (trace->records == NULL || mapped == NULL) {
+        LOG_ERR("could not allocate memory for %" PRIu64 " records\n", hdr->nrecords);
+        goto err_out;
+    }
+
+    if (fread(trace->records, sizeof(struct vmops_replay_record), hdr->nrecords, f)
+        != hdr->nrecords) {
+        LOG_ERR("the replay trace '%s' is truncated\n", path);
+        goto err_out;
+    }
+
+    for (size_t i = 0; i < hdr->nrecords; i++) {
+        struct vmops_replay_record *rec = &trace->records[i];
+
+        if (rec->slot >= hdr->nslots || rec->op > VMOPS_REPLAY_OP_PROTECT || rec->size == 0) {
+            LOG_ERR("record %zu of the replay trace is invalid\n", i);
+            goto err_out;
+        }
+
+        if (rec->offset % pagesize) {
+            LOG_ERR("record %zu is not aligned to the page size %zu\n", i, pagesize);
+            goto err_out;
+        }
+
+        rec->size = (rec->size + pagesize - 1) & ~(pagesize - 1);
+
+        if (rec->op == VMOPS_REPLAY_OP_MAP) {
+            if (mapped[rec->slot] != 0 || rec->offset != 0) {
+                LOG_ERR("record %zu maps slot %u that is still mapped\n", i, rec->slot);
+                goto err_out;
+            }
+
+            mapped[rec->slot] = rec->size;
+            trace->maxsize = rec->size > trace->maxsize ? rec->size : trace->maxsize;
+            continue;
+        }
+
+        if (rec->offset + rec->size > mapped[rec->slot]) {
+            LOG_ERR("record %zu exceeds the mapping of slot %u\n", i, rec->slot);
+            goto err_out;
+        }
+
+        /* partially unmapped slots remain mapped, even once all of their ranges are unmapped */
+        if (rec->op == VMOPS_REPLAY_OP_UNMAP && rec->offset == 0
+            && rec->size == mapped[rec->slot]) {
+            mapped[rec->slot] = 0;
+        }
+    }
+
+    free(mapped);
+    fclose(f);
+
+    return 0;
+
+err_out:
+    free(mapped);
+    free(trace->records);
+    trace->records = NULL;
+    fclose(f);
+    return -1;
+}
+
+
+static int replay_range_cmp(const void *a, const void *b)
+{
+    const struct replay_range *ra = a;
+    const struct replay_range *rb = b;
+
+    if (ra->slot != rb->slot) {
+        return ra->slot < rb->slot ? -1 : 1;
+    }
+
+    return ra->start < rb->start ? -1 : ra->start > rb->start;
+}
+
+
+/**
+ * @brief unmaps what remains of the mappings of all address slots
+ *
+ * @param records   the records that have been replayed
+ * @param nrecords  the number of records that have been replayed
+ * @param slots     the address slots
+ * @param nslots    the number of address slots
+ * @param ranges    scratch space for one range per record
+ *
+ * Other mappings may have been placed into the holes of partially unmapped slots, thus only
+ * the ranges that have not been unmapped since the slot was mapped are unmapped.
+ */
+static void replay_unmap_all(struct vmops_replay_record *records, size_t nrecords,
+                             struct replay_slot *slots, size_t nslots,
+                             struct replay_range *ranges)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < nrecords; i++) {
+        struct vmops_replay_record *rec = &records[i];
+        struct replay_slot *slot = &slots[rec->slot];
+        if (rec->op == VMOPS_REPLAY_OP_UNMAP && slot->addr != NULL && i > slot->idx) {
+            ranges[n].slot = rec->slot;
+            ranges[n].start = rec->offset;
+            ranges[n].end = rec->offset + rec->size;
+            n++;
+        }
+    }
+
+    qsort(ranges, n, sizeof(struct replay_range), replay_range_cmp);
+
+    size_t r = 0;
+    for (uint32_t i = 0; i < nslots; i++) {
+        if (slots[i].addr == NULL) {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (; r < n && ranges[r].slot == i; r++) {
+            if (ranges[r].start > offset) {
+                plat_vm_unmap(slots[i].addr + offset, ranges[r].start - offset);
+            }
+            offset = ranges[r].end > offset ? ranges[r].end : offset;
+        }
+
+        if (offset < slots[i].size) {
+            plat_vm_unmap(slots[i].addr + offset, slots[i].size - offset);
+        }
+
+        slots[i].addr = NULL;
+    }
+}
+
+
+static void *bench_run_fn(struct vmops_bench_run_arg *args)
+{
+    plat_error_t err;
+
+    struct vmops_bench_cfg *cfg = args->cfg;
+    struct replay_trace *trace = (struct replay_trace *)args->shared;
+
+    plat_time_t t_delta = plat_convert_time(args->cfg->time_ms);
+    if (t_delta == 0) {
+        t_delta = PLAT_TIME_MAX;
+    }
+
+    size_t nops = cfg->nops;
+    if (nops == 0) {
+        nops = SIZE_MAX;
+    }
+
+    /* each thread replays its own copy of the trace, allocated on its own node */
+    size_t nrecords = trace->hdr.nrecords;
+    size_t nslots = trace->hdr.nslots;
+    struct vmops_replay_record *records = malloc(nrecords * sizeof(struct vmops_replay_record));
+    struct replay_slot *slots = calloc(nslots, sizeof(struct replay_slot));
+    struct replay_range *ranges = malloc(nrecords * sizeof(struct replay_range));
+    if (records == NULL || slots == NULL || ranges == NULL) {
+        LOG_ERR("thread %d failed to allocate its copy of the trace. exiting.\n", args->tid);
+        free(records);
+        free(slots);
+        free(ranges);
+        return NULL;
+    }
+
+    memcpy(records, trace->records, nrecords * sizeof(struct vmops_replay_record));
+
+    double ticks_per_ns = plat_convert_time(1) / 1e6;
+
+    LOG_INFO("thread %d ready.\n", args->tid);
+    plat_time_t t_current = vmops_utils_window_begin(args);
+
+    plat_time_t t_end = t_delta == PLAT_TIME_MAX ? PLAT_TIME_MAX : t_current + t_delta;
+    plat_time_t t_start = t_current;
+
+    /* the trace is replayed over and over, each pass starts with all slots unmapped */
+    size_t counter = 0;
+    size_t idx = 0;
+    size_t passes = 0;
+    plat_time_t lag = 0;
+    plat_time_t t_pass = t_current;
+    while (t_current < t_end && counter < nops) {
+        struct vmops_replay_record *rec = &records[idx];
+        struct replay_slot *slot = &slots[rec->slot];
+
+        plat_time_t t_op_start;
+        if (cfg->replaytimed) {
+            /* the operation is due at its recorded time, lagging behind counts as latency */
+            t_op_start = t_pass + (plat_time_t)(rec->t_ns * ticks_per_ns);
+            while (t_current < t_op_start && t_current < t_end) {
+                t_current = plat_get_time();
+            }
+
+            if (t_current < t_op_start) {
+                break;
+            }
+
+            lag = t_current - t_op_start > lag ? t_current - t_op_start : lag;
+        } else {
+            t_op_start = vmops_utils_op_start(&args->stats, t_current);
+        }
+
+        vmops_op_t op;
+        switch (rec->op) {
+        case VMOPS_REPLAY_OP_MAP:
+            op = VMOPS_OP_MAP;
+            slot->addr = NULL;
+            slot->size = rec->size;
+            slot->idx = idx;
+            err = plat_vm_map_lazy((void **)&slot->addr, rec->size, args->memobj, 0,
+                                   cfg->pages);
+            break;
+        case VMOPS_REPLAY_OP_UNMAP:
+            op = VMOPS_OP_UNMAP;
+            err = plat_vm_unmap(slot->addr + rec->offset, rec->size);
+            break;
+        default:
+            op = VMOPS_OP_PROTECT;
+            err = plat_vm_protect(slot->addr + rec->offset, rec->size,
+                                  (rec->prot & VMOPS_REPLAY_PROT_WRITE) ? PLAT_PERM_READ_WRITE
+                                                                         : PLAT_PERM_READ_ONLY);
+            break;
+        }
+
+        t_current = plat_get_time();
+
+        if (err != PLAT_ERR_OK) {
+            LOG_ERR("thread %d. failed to replay record %zu ops=%zu!\n", args->tid, idx,
+                    counter);
+            if (op == VMOPS_OP_MAP) {
+                slot->addr = NULL;
+            }
+            goto err_out;
+        }
+
+        vmops_utils_add_stats(&args->stats, op, args->tid, counter, t_current - t_start,
+                              t_current - t_op_start);
+
+        if (op == VMOPS_OP_UNMAP && rec->offset == 0 && rec->size == slot->size) {
+            slot->addr = NULL;
+        }
+
+        counter++;
+        vmops_utils_warmup(args, t_current, &counter, &t_start, &t_end);
+        if (counter == 0) {
+            passes = 0;
+            lag = 0;
+        }
+
+        if (++idx == nrecords) {
+            replay_unmap_all(records, nrecords, slots, nslots, ranges);
+            idx = 0;
+            passes++;
+            t_current = plat_get_time();
+            t_pass = t_current;
+        }
+    }
+    t_end = plat_get_time();
+
+    args->count = counter;
+    args->duration = plat_time_to_ms(t_end - t_start);
+
+err_out:
+    vmops_utils_window_end(args);
+
+    replay_unmap_all(records, idx, slots, nslots, ranges);
+
+    trace->passes[args->tid] = passes;
+    trace->lag[args->tid] = lag;
+
+    free(records);
+    free(slots);
+    free(ranges);
+
+    LOG_INFO("thread %d done. ops = %zu, time=%.3f\n", args->tid, counter, args->duration);
+
+    return NULL;
+}
+
+
+/**
+ * @brief starts the trace replay benchmark
+ *
+ * @param cfg   the benchmark configuration
+ * @param opts  the options for the benchmark
+ *
+ * @returns 0 success, -1 error
+ */
+int vmops_bench_run_replay(struct vmops_bench_cfg *cfg, const char *opts)
+{
+    if (vmops_utils_parse_options(opts, cfg)) {
+        LOG_ERR("failed to parse the options\n");
+        return -1;
+    }
+
+    if (cfg->map4k || cfg->isolated) {
+        LOG_ERR("the replay benchmark does not support options '4k' and 'isolated'\n");
+        return -1;
+    }
+
+    if (cfg->replayfile == NULL) {
+        LOG_ERR("the replay benchmark needs a replay trace, see option -Y\n");
+        return -1;
+    }
+
+    struct replay_trace trace;
+    if (replay_load(cfg->replayfile, plat_page_size(cfg->pages), &trace)) {
+        LOG_ERR("failed to load the replay trace\n");
+        return -1;
+    }
+
+    /* the results are shared with the benchmark processes */
+    trace.passes = NULL;
+    trace.lag = NULL;
+    if (plat_mem_alloc(cfg->corelist_size * sizeof(size_t), (void **)&trace.passes)
+        || plat_mem_alloc(cfg->corelist_size * sizeof(plat_time_t), (void **)&trace.lag)) {
+        LOG_ERR("could not allocate memory for the replay results\n");
+        goto err_out;
+    }
+
+    /* all mappings map the memory object from its start, it must hold the largest one */
+    cfg->memsize = trace.maxsize;
+
+    LOG_INFO("Preparing benchmark. 'replay' with options '%s'\n", vmops_utils_print_options(cfg));
+    LOG_INFO("each core replays %" PRIu64 " records of %u recorded threads %s\n",
+             trace.hdr.nrecords, trace.hdr.nthreads,
+             cfg->replaytimed ? "with their recorded timing" : "as fast as possible");
+    LOG_INFO("the largest mapping of the trace has %zu bytes\n", trace.maxsize);
+
+    struct vmops_bench_run_arg *args;
+    if (vmops_utils_prepare_args(cfg, &trace, &args)) {
+        LOG_ERR("failed to prepare arguments\n");
+        goto err_out;
+    }
+
+    if (vmops_utils_run_benchmark(cfg->corelist_size, args, bench_run_fn)) {
+        LOG_ERR("failed to run the benchmark\n");
+        goto err_out;
+    }
+
+    vmops_utils_print_csv(args);
+
+    size_t passes = 0;
+    plat_time_t lag = 0;
+    for (uint32_t i = 0; i < cfg->corelist_size; i++) {
+        passes += trace.passes[i];
+        lag = trace.lag[i] > lag ? trace.lag[i] : lag;
+    }
+
+    LOG_RESULT_REPLAY(cfg->benchmark, (size_t)trace.hdr.nrecords, trace.hdr.nslots, passes,
+                      cfg->replaytimed ? plat_time_to_ms(lag) : 0.0);
+
+    vmops_utils_cleanup_args(args);
+
+    free(trace.records);
+    plat_mem_free(trace.passes, cfg->corelist_size * sizeof(size_t));
+    plat_mem_free(trace.lag, cfg->corelist_size * sizeof(plat_time_t));
+
+    return 0;
+
+err_out:
+    free(trace.records);
+    plat_mem_free(trace.passes, cfg->corelist_size * sizeof(size_t));
+    plat_mem_free(trace.lag, cfg->corelist_size * sizeof(plat_time_t));
+    return -1;
+}
@@ -0,0 +1,67 @@
+/*
+ * Virtual Memory Operations Benchmark
+ *
+ * Copyright 2020 Reto Achermann
+ * SPDX-License-Identifier: GPL-3.0
+ */
+
+#ifndef __VMOPS_REPLAY_H_
+#define __VMOPS_REPLAY_H_ 1
+
+#include <stdint.h>
+
+
+/*
+ * ================================================================================================
+ * Replay Trace File Format
+ * ================================================================================================
+ *
+ * The replay trace starts with a header, followed by nrecords operation records in the order
+ * they were recorded. A mapping is identified by its address slot instead of its address. A map
+ * assigns the address it obtains to the slot, the following operations on the slot address the
+ * mapping relative to its start. A map is always read-write, later protects change that. All
+ * values are in the byte order of the host.
+ */
+
+
+///< identifies a replay trace file
+#define VMOPS_REPLAY_MAGIC "VMOPSRPL"
+
+///< the version of the replay trace file format
+#define VMOPS_REPLAY_VERSION 1
+
+///< the recorded operations
+typedef enum {
+    VMOPS_REPLAY_OP_MAP = 0,      ///< maps size bytes and assigns the mapping to the slot
+    VMOPS_REPLAY_OP_UNMAP = 1,    ///< unmaps size bytes at offset of the slot's mapping
+    VMOPS_REPLAY_OP_PROTECT = 2,  ///< changes the protection of size bytes at offset
+} vmops_replay_op_t;
+
+///< the protection of a protect, writable ranges become read-write, all others read-only
+#define VMOPS_REPLAY_PROT_READ (1U << 0)
+#define VMOPS_REPLAY_PROT_WRITE (1U << 1)
+#define VMOPS_REPLAY_PROT_EXEC (1U << 2)
+
+struct vmops_replay_header
+{
+    char magic[8];         ///< VMOPS_REPLAY_MAGIC
+    uint32_t version;      ///< VMOPS_REPLAY_VERSION
+    uint32_t record_size;  ///< the size of an operation record
+    uint64_t nrecords;     ///< the number of operation records in the file
+    uint32_t nslots;       ///< the number of address slots used by the records
+    uint32_t nthreads;     ///< the number of recorded threads
+};
+
+struct vmops_replay_record
+{
+    uint64_t t_ns;    ///< the time of the operation relative to the start of the recording
+    uint64_t offset;  ///< the offset of the range into the mapping of the slot, 0 for a map
+    uint64_t size;    ///< the size of the range in bytes
+    uint32_t slot;    ///< the address slot of the mapping
+    uint16_t tid;     ///< the recorded thread that executed the operation
+    uint8_t op;       ///< vmops_replay_op_t
+    uint8_t prot;     ///< VMOPS_REPLAY_PROT_* of the operation
+};
+
+
+#endif /* __VMOPS_REPLAY_H_ */
@@ -0,0 +1,375 @@
+/*
+ * Virtual Memory Operations Benchmark
+ *
+ * Copyright 2020 Reto Achermann
+ * SPDX-License-Identifier: GPL-3.0
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "report.h"
+#include "utils.h"
+
+
+/*
+ * ================================================================================================
+ * JSON Writer
+ * ================================================================================================
+ */
+
+
+struct json
+{
+    FILE *f;     ///< the file the json is written to
+    bool first;  ///< whether the next member is the first of the current object or array
+};
+
+
+/**
+ * @brief writes a json string with the required characters escaped
+ *
+ * @param f     the file to write to
+ * @param s     the string to be written
+ */
+static void json_escape(FILE *f, const char *s)
+{
+    fputc('"', f);
+    for (; *s != 0; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            fprintf(f, "\\%c", c);
+        } else if (c == '\n') {
+            fputs("\\n", f);
+        } else if (c == '\t') {
+            fputs("\\t", f);
+        } else if (c < 0x20) {
+            fprintf(f, "\\u%04x", c);
+        } else {
+            fputc(c, f);
+        }
+    }
+    fputc('"', f);
+}
+
+
+/**
+ * @brief writes the separator and the key of the next member
+ *
+ * @param j     the json writer
+ * @param key   the key of the member, NULL for array elements
+ */
+static void json_key(struct json *j, const char *key)
+{
+    if (!j->first) {
+        fputc(',', j->f);
+    }
+    j->first = false;
+
+    if (key != NULL) {
+        json_escape(j->f, key);
+        fputc(':', j->f);
+    }
+}
+
+
+static void json_open(struct json *j, const char *key, char bracket)
+{
+    json_key(j, key);
+    fputc(bracket, j->f);
+    j->first = true;
+}
+
+
+static void json_close(struct json *j, char bracket)
+{
+    fputc(bracket, j->f);
+    j->first = false;
+}
+
+
+static void json_str(struct json *j, const char *key, const char *val)
+{
+    json_key(j, key);
+    json_escape(j->f, val);
+}
+
+
+static void json_u64(struct json *j, const char *key, uint64_t val)
+{
+    json_key(j, key);
+    fprintf(j->f, "%" PRIu64, val);
+}
+
+
+static void json_dbl(struct json *j, const char *key, double val)
+{
+    json_key(j, key);
+    fprintf(j->f, "%.6f", val);
+}
+
+
+static void json_bool(struct json *j, const char *key, bool val)
+{
+    json_key(j, key);
+    fputs(val ? "true" : "false", j->f);
+}
+
+
+/*
+ * ================================================================================================
+ * Result Record
+ * ================================================================================================
+ */
+
+
+struct report_env
+{
+    struct json *j;   ///< the json writer
+    char group[64];   ///< the group that is currently open, empty if none
+};
+
+
+/**
+ * @brief adds a property of the system environment to the record
+ *
+ * @param st    the environment state
+ * @param group the group of the property, NULL for top-level properties
+ * @param key   the name of the property
+ * @param value the value of the property
+ */
+static void report_env_fn(void *st, const char *group, const char *key, const char *value)
+{
+    struct report_env *env = (struct report_env *)st;
+    const char *current = env->group[0] ? env->group : NULL;
+
+    bool same = (group == NULL && current == NULL)
+                || (group != NULL && current != NULL && strcmp(group, current) == 0);
+    if (!same) {
+        if (current != NULL) {
+            json_close(env->j, '}');
+        }
+
+        env->group[0] = 0;
+        if (group != NULL) {
+            json_open(env->j, group, '{');
+            strncpy(env->group, group, sizeof(env->group) - 1);
+        }
+    }
+
+    json_str(env->j, key, value);
+}
+
+
+/**
+ * @brief adds the summary of a latency histogram to the record
+ *
+ * @param j     the json writer
+ * @param key   the name of the summary
+ * @param hist  the histogram
+ */
+static void report_hist(struct json *j, const char *key, const struct vmops_hist *hist)
+{
+    json_open(j, key, '{');
+    json_u64(j, "count", hist->count);
+    json_dbl(j, "mean", plat_time_to_ms(vmops_hist_mean(hist)));
+    json_dbl(j, "min", hist->count ? plat_time_to_ms(hist->min) : 0.0);
+    json_dbl(j, "p50", plat_time_to_ms(vmops_hist_percentile(hist, 50.0)));
+    json_dbl(j, "p90", plat_time_to_ms(vmops_hist_percentile(hist, 90.0)));
+    json_dbl(j, "p99", plat_time_to_ms(vmops_hist_percentile(hist, 99.0)));
+    json_dbl(j, "p999", plat_time_to_ms(vmops_hist_percentile(hist, 99.9)));
+    json_dbl(j, "max", plat_time_to_ms(hist->max));
+    json_close(j, '}');
+}
+
+
+/**
+ * @brief adds the configuration of the benchmark to the record
+ *
+ * @param j     the json writer
+ * @param cfg   the benchmark configuration
+ */
+static void report_config(struct json *j, struct vmops_bench_cfg *cfg)
+{
+    json_open(j, "config", '{');
+    json_str(j, "benchmark", cfg->benchmark);
+    json_u64(j, "ncores", cfg->corelist_size);
+    json_open(j, "cores", '[');
+    for (uint32_t i = 0; i < cfg->corelist_size; i++) {
+        json_u64(j, NULL, cfg->coreslist[i]);
+    }
+    json_close(j, ']');
+    json_u64(j, "memsize", cfg->memsize);
+    json_u64(j, "time_ms", cfg->time_ms);
+    json_u64(j, "nops", cfg->nops);
+    json_u64(j, "oprate", cfg->oprate);
+    json_u64(j, "warmup_ms", cfg->warmup_ms);
+    json_dbl(j, "steady_cv", cfg->steady_cv);
+    json_u64(j, "reps", cfg->reps);
+    json_dbl(j, "reps_ci", cfg->reps_ci);
+    json_bool(j, "numainterleave", cfg->numainterleave);
+    json_bool(j, "map4k", cfg->map4k);
+    json_str(j, "page_size", vmops_utils_page_size_name(cfg));
+    json_bool(j, "shared", cfg->shared);
+    json_str(j, "memobj", vmops_utils_memobj_name(cfg));
+    json_str(j, "memobj_dir", cfg->memobj_dir);
+    json_bool(j, "isolated", cfg->isolated);
+    json_bool(j, "ranged", cfg->ranged);
+    json_bool(j, "processes", cfg->processes);
+    json_u64(j, "unmappers", cfg->unmappers);
+    json_u64(j, "victims", cfg->victims < 0 ? 0 : cfg->victims);
+    json_u64(j, "victim_pages", cfg->victim_pages);
+    json_u64(j, "unmap_batch", cfg->unmap_batch);
+    json_u64(j, "split_stride", cfg->split == VMOPS_SPLIT_STRIDE ? cfg->split_stride : 0);
+    json_str(j, "mix", cfg->mix != NULL ? cfg->mix : "");
+    json_u64(j, "seed", cfg->seed);
+    json_str(j, "replay", cfg->replayfile != NULL ? cfg->replayfile : "");
+    json_bool(j, "replay_timed", cfg->replaytimed);
+    json_u64(j, "population", cfg->population);
+    json_u64(j, "vmas", cfg->vmas);
+    json_close(j, '}');
+}
+
+
+/**
+ * @brief adds the throughput and latency results to the record
+ *
+ * @param j     the json writer
+ * @param args  the benchmark arguments
+ * @param hist  scratch space for two histograms
+ */
+static void report_results(struct json *j, struct vmops_bench_run_arg *args,
+                           struct vmops_hist *hist)
+{
+    struct vmops_bench_cfg *cfg = args->cfg;
+
+    size_t total_ops = 0;
+    double total_time = 0;
+    double thpt = 0;
+
+    json_open(j, "results", '{');
+
+    json_open(j, "threads", '[');
+    for (uint32_t i = 0; i < cfg->corelist_size; i++) {
+        double t_thpt = args[i].duration > 0 ? args[i].count * 1000.0 / args[i].duration : 0;
+
+        json_open(j, NULL, '{');
+        json_u64(j, "tid", i);
+        json_u64(j, "core", cfg->coreslist[i]);
+        json_u64(j, "ops", args[i].count);
+        json_dbl(j, "duration", args[i].duration);
+        json_dbl(j, "thpt", t_thpt);
+        json_bool(j, "background", args[i].background);
+        json_dbl(j, "wake", plat_time_to_ms(args[i].t_wake));
+        json_dbl(j, "late", plat_time_to_ms(args[i].t_late));
+        if (args->irqcounts != NULL && cfg->coreslist[i] < PLAT_IRQSTATS_MAX_CORES) {
+            uint64_t *ipis = args->irqcounts[1].ipis[cfg->coreslist[i]];
+            json_u64(j, "tlb_ipis", ipis[PLAT_IPI_TLB_SHOOTDOWN]);
+            json_u64(j, "call_ipis", ipis[PLAT_IPI_FUNCTION_CALL]);
+        }
+        json_close(j, '}');
+
+        if (args[i].background) {
+            continue;
+        }
+
+        total_ops += args[i].count;
+        total_time += args[i].duration;
+        thpt += t_thpt;
+    }
+    json_close(j, ']');
+
+    json_u64(j, "ops", total_ops);
+    json_dbl(j, "duration", total_time);
+    json_dbl(j, "thpt", thpt);
+
+    /* the first histogram holds all operations, the second one a single operation type */
+    struct vmops_hist *ophist = hist + 1;
+    vmops_hist_reset(hist);
+
+    json_open(j, "latency", '{');
+    for (uint32_t op = 0; op < VMOPS_OP_MAX; op++) {
+        vmops_hist_reset(ophist);
+        for (uint32_t i = 0; i < cfg->corelist_size; i++) {
+            vmops_hist_merge(ophist, &args[i].stats.hist[op]);
+        }
+
+        if (ophist->count != 0) {
+            report_hist(j, vmops_utils_op_name(op), ophist);
+            vmops_hist_merge(hist, ophist);
+        }
+    }
+    report_hist(j, "all", hist);
+    json_close(j, '}');
+
+    struct vmops_reps *reps = args->reps;
+    if (reps != NULL && reps->n > 0) {
+        json_open(j, "reps", '{');
+        json_u64(j, "n", reps->n);
+        json_open(j, "thpt", '[');
+        for (uint32_t i = 0; i < reps->n; i++) {
+            json_dbl(j, NULL, reps->thpt[i]);
+        }
+        json_close(j, ']');
+        json_close(j, '}');
+    }
+
+    json_close(j, '}');
+}
+
+
+/**
+ * @brief appends the result record of the benchmark as a single line of json to jsonout
+ *
+ * @param args  the benchmark arguments
+ */
+void vmops_report_json(struct vmops_bench_run_arg *args)
+{
+    if (jsonout == NULL || args == NULL || args->cfg == NULL) {
+        return;
+    }
+
+    struct vmops_bench_cfg *cfg = args->cfg;
+
+    struct vmops_hist *hist = malloc(2 * sizeof(struct vmops_hist));
+    if (hist == NULL) {
+        LOG_ERR("could not allocate memory for the json record\n");
+        return;
+    }
+
+    struct json j = { .f = jsonout, .first = true };
+
+    char timestamp[32];
+    time_t now = time(NULL);
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+    json_open(&j, NULL, '{');
+    json_u64(&j, "version", VMOPS_REPORT_VERSION);
+    json_str(&j, "timestamp", timestamp);
+    json_str(&j, "git_rev", VMOPS_GIT_REV);
+
+    json_open(&j, "cmdline", '[');
+    for (int i = 0; i < cfg->argc; i++) {
+        json_str(&j, NULL, cfg->argv[i]);
+    }
+    json_close(&j, ']');
+
+    report_config(&j, cfg);
+
+    json_open(&j, "environment", '{');
+    struct report_env env = { .j = &j };
+    plat_get_environment(report_env_fn, &env);
+    if (env.group[0]) {
+        json_close(&j, '}');
+    }
+    json_close(&j, '}');
+
+    report_results(&j, args, hist);
+
+    json_close(&j, '}');
+    fputc('\n', jsonout);
+    fflush(jsonout);
+
+    free(hist);
+}
@@ -0,0 +1,33 @@
+/*
+ * Virtual Memory Operations Benchmark
+ *
+ * Copyright 2020 Reto Achermann
+ * SPDX-License-Identifier: GPL-3.0
+ */
+
+#ifndef __VMOPS_REPORT_H_
+#define __VMOPS_REPORT_H_ 1
+
+#include "benchmarks.h"
+
+
+///< the version of the json result record
+#define VMOPS_REPORT_VERSION 2
+
+#ifndef VMOPS_GIT_REV
+#define VMOPS_GIT_REV "unknown"
+#endif
+
+
+/**
+ * @brief appends the result record of the benchmark as a single line of json to jsonout
+ *
+ * @param args  the benchmark arguments
+ *
+ * The record holds the configuration, the command line, the system environment and the
+ * throughput and latency summaries of the benchmark run.
+ */
+void vmops_report_json(struct vmops_bench_run_arg *args);
+
+
+#endif /* __VMOPS_REPORT_H_ */
@@ -9,12 +9,130 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdbool.h>
 
 #include "benchmarks.h"
 #include "utils.h"
 
 #define VMOBJ_NAME "/vmops_bench_tlbshoot_independent_%d"
 
+///< the number of page accesses after which a victim checks for the end of the warmup
+#define VICTIM_WARMUP_POLL 0x400
+
+///< the state shared by the unmapping and the victim threads
+struct tlbshoot_state
+{
+    uint32_t unmappers;  ///< the number of unmappers that are still running
+    bool stop;           ///< set by the last unmapper to stop the victims
+};
+
+
+/**
+ * @brief assigns the role of a thread and resets the shared state for the repetition
+ *
+ * @param args      the arguments of the thread
+ * @param victim    returns whether a thread that is not an unmapper is a victim
+ *
+ * @returns true if the thread is an unmapper, false otherwise
+ */
+static bool tlbshoot_role(struct vmops_bench_run_arg *args, bool *victim)
+{
+    struct vmops_bench_cfg *cfg = args->cfg;
+    struct tlbshoot_state *st = (struct tlbshoot_state *)args->shared;
+
+    /* the state is still set from the previous repetition */
+    if (args->tid == 0) {
+        st->unmappers = cfg->unmappers;
+        st->stop = false;
+    }
+
+    bool unmapper = args->tid < cfg->unmappers;
+    *victim = !unmapper && args->tid < cfg->unmappers + (uint32_t)cfg->victims;
+    args->background = !unmapper;
+
+    LOG_INFO("thread %d ready. %s\n", args->tid,
+             unmapper ? "unmapper" : (*victim ? "victim" : "idle"));
+
+    return unmapper;
+}
+
+
+/**
+ * @brief signals the end of an unmapper, the last one stops the victims
+ *
+ * @param args      the arguments of the unmapper thread
+ */
+static void tlbshoot_unmapper_done(struct vmops_bench_run_arg *args)
+{
+    struct tlbshoot_state *st = (struct tlbshoot_state *)args->shared;
+
+    /* the victims keep touching their pages until the last unmapper is done */
+    if (__atomic_sub_fetch(&st->unmappers, 1, __ATOMIC_ACQ_REL) == 0) {
+        __atomic_store_n(&st->stop, true, __ATOMIC_RELEASE);
+    }
+}
+
+
+/**
+ * @brief runs a thread that is not an unmapper until the unmappers have finished
+ *
+ * @param args      the arguments of the thread
+ * @param taddr     the thread's mapping of the memory object
+ * @param victim    whether the thread touches the pages of its mapping
+ *
+ * @returns NULL
+ */
+static void *tlbshoot_background_run(struct vmops_bench_run_arg *args, void *taddr, bool victim)
+{
+    struct tlbshoot_state *st = (struct tlbshoot_state *)args->shared;
+
+    plat_time_t t_current = vmops_utils_window_begin(args);
+
+    if (!victim) {
+        vmops_utils_window_end(args);
+        args->count = 0;
+        args->duration = 0;
+        plat_vm_unmap(taddr, args->cfg->memsize);
+        return NULL;
+    }
+
+    /* every access needs a translation of a page, cached in the TLB of the victim */
+    volatile uint64_t *page = (volatile uint64_t *)taddr;
+    size_t stride = plat_page_size(args->cfg->pages) / sizeof(uint64_t);
+    size_t npages = args->cfg->victim_pages;
+
+    /* the victim runs until it is stopped, the end is only used by the warmup */
+    plat_time_t t_start = t_current;
+    plat_time_t t_end = PLAT_TIME_MAX;
+    size_t counter = 0;
+    size_t idx = 0;
+
+    while (!__atomic_load_n(&st->stop, __ATOMIC_ACQUIRE)) {
+        page[idx * stride]++;
+        if (++idx == npages) {
+            idx = 0;
+        }
+
+        counter++;
+        if ((counter % VICTIM_WARMUP_POLL) == 0 && args->stats.warmup) {
+            vmops_utils_warmup(args, plat_get_time(), &counter, &t_start, &t_end);
+        }
+    }
+    t_end = plat_get_time();
+
+    vmops_utils_window_end(args);
+
+    args->count = counter;
+    args->duration = plat_time_to_ms(t_end - t_start);
+
+    LOG_INFO("thread %d done. accesses = %zu, time=%.3f\n", args->tid, counter, args->duration);
+
+    plat_vm_unmap(taddr, args->cfg->memsize);
+
+    return NULL;
+}
+
+
 static void *bench_run_fn(struct vmops_bench_run_arg *args)
 {
     plat_error_t err;
@@ -32,105 +150,141 @@ static void *bench_run_fn(struct vmops_bench_run_arg *args)
     }
     size_t memsize = args->cfg->memsize;
     void *taddr;
-    err = plat_vm_map(&taddr, memsize, args->memobj, 0, cfg->maphuge);
+    err = plat_vm_map(&taddr, memsize, args->memobj, 0, cfg->pages);
     if (err != PLAT_ERR_OK) {
         LOG_ERR("thread %d. failed to map memory!\n", args->tid);
         return NULL;
     }
 
-    LOG_INFO("thread %d ready.\n", args->tid);
-    plat_thread_barrier(args->barrier);
+    bool victim;
+    if (!tlbshoot_role(args, &victim)) {
+        return tlbshoot_background_run(args, taddr, victim);
+    }
+
+    plat_time_t t_current = vmops_utils_window_begin(args);
 
-    plat_time_t t_current = plat_get_time();
     plat_time_t t_end = t_delta == PLAT_TIME_MAX ? PLAT_TIME_MAX : t_current + t_delta;
     plat_time_t t_start = t_current;
     size_t counter = 0;
 
-    uint64_t *done = (uint64_t*)args->shared;
-    if (args->tid != 0) {
-        uint64_t *sum = (uint64_t*)taddr;
-        while(!*done) {
-            *sum = *sum + 1;
-        }
-        plat_thread_barrier(args->barrier);
-
-        args->count = counter;
-        args->duration = plat_time_to_ms(t_end - t_start);
-
-        LOG_INFO("thread %d done. ops = %zu, time=%.3f\n", args->tid, *sum, args->duration);
-
-        return NULL;
-    }
-
     if (cfg->isolated) {
         void *addr = utils_vmops_get_map_address(args->tid);
         while (t_current < t_end && counter < nops) {
-            err = plat_vm_map_fixed(addr, memsize, args->memobj, 0, cfg->maphuge);
+            plat_time_t t_op_start = vmops_utils_op_start(&args->stats, t_current);
+            err = plat_vm_map_fixed(addr, memsize, args->memobj, 0, cfg->pages);
             if (err != PLAT_ERR_OK) {
                 LOG_ERR("thread %d. failed to map memory ops=%zu!\n", args->tid, counter);
-                return NULL;
+                goto err_out;
             }
 
-            plat_time_t t_op_start = t_current;
+            plat_time_t t_map_end = plat_get_time();
+
             err = plat_vm_unmap(addr, memsize);
             if (err != PLAT_ERR_OK) {
                 LOG_ERR("thread %d. failed to unmap memory ops=%zu!\n", args->tid, counter);
-                return NULL;
+                goto err_out;
             }
+
             t_current = plat_get_time();
 
-            vmops_utils_add_stats(&args->stats, args->tid, counter, t_current - t_start,
-                                  t_current - t_op_start);
+            vmops_utils_add_stats(&args->stats, VMOPS_OP_MAP, args->tid, counter,
+                                  t_map_end - t_start, t_map_end - t_op_start);
+            vmops_utils_add_stats(&args->stats, VMOPS_OP_UNMAP, args->tid, counter,
+                                  t_current - t_start, t_current - t_map_end);
 
             counter++;
+            vmops_utils_warmup(args, t_current, &counter, &t_start, &t_end);
         }
     } else {
         while (t_current < t_end && counter < nops) {
+            plat_time_t t_op_start = vmops_utils_op_start(&args->stats, t_current);
             void *addr;
-            err = plat_vm_map(&addr, memsize, args->memobj, 0, cfg->maphuge);
+            err = plat_vm_map(&addr, memsize, args->memobj, 0, cfg->pages);
             if (err != PLAT_ERR_OK) {
                 LOG_ERR("thread %d. failed to map memory ops=%zu!\n", args->tid, counter);
-                return NULL;
+                goto err_out;
             }
 
-            plat_time_t t_op_start = t_current;
+            plat_time_t t_map_end = plat_get_time();
+
             err = plat_vm_unmap(addr, memsize);
             if (err != PLAT_ERR_OK) {
                 LOG_ERR("thread %d. failed to unmap memory ops=%zu!\n", args->tid, counter);
-                return NULL;
+                goto err_out;
             }
 
             t_current = plat_get_time();
-            vmops_utils_add_stats(&args->stats, args->tid, counter, t_current - t_start,
-                                  t_current - t_op_start);
+
+            vmops_utils_add_stats(&args->stats, VMOPS_OP_MAP, args->tid, counter,
+                                  t_map_end - t_start, t_map_end - t_op_start);
+            vmops_utils_add_stats(&args->stats, VMOPS_OP_UNMAP, args->tid, counter,
+                                  t_current - t_start, t_current - t_map_end);
 
             counter++;
+            vmops_utils_warmup(args, t_current, &counter, &t_start, &t_end);
         }
     }
     t_end = plat_get_time();
 
-    *done = 0x1;
-
-    plat_thread_barrier(args->barrier);
-
     args->count = counter;
     args->duration = plat_time_to_ms(t_end - t_start);
 
+err_out:
+    tlbshoot_unmapper_done(args);
+
+    vmops_utils_window_end(args);
+
     LOG_INFO("thread %d done. ops = %zu, time=%.3f\n", args->tid, counter, args->duration);
 
+    plat_vm_unmap(taddr, memsize);
+
     return NULL;
 }
 
-#if 0
+/**
+ * @brief maps a batch of pages of the unmapper's region
+ *
+ * @param args      the arguments of the unmapper thread
+ * @param base      the start of the unmapper's region
+ * @param batch     the index of the batch to be mapped
+ *
+ * @returns error value
+ *
+ * The batch is either mapped as one range, or as adjacent mappings of single pages.
+ */
+static plat_error_t tlbshoot_map_batch(struct vmops_bench_run_arg *args, void *base, size_t batch)
+{
+    struct vmops_bench_cfg *cfg = args->cfg;
+
+    size_t npages = cfg->unmap_batch;
+    size_t pagesize = plat_page_size(cfg->pages);
+    off_t offset = batch * npages * pagesize;
+    void *addr = (void *)((uintptr_t)base + offset);
+
+    if (cfg->ranged) {
+        return plat_vm_map_fixed(addr, npages * pagesize, args->memobj, offset, cfg->pages);
+    }
+
+    for (size_t i = 0; i < npages; i++) {
+        plat_error_t err = plat_vm_map_fixed(addr, pagesize, args->memobj, offset, cfg->pages);
+        if (err != PLAT_ERR_OK) {
+            return err;
+        }
+
+        addr = (void *)((uintptr_t)addr + pagesize);
+        offset += pagesize;
+    }
+
+    return PLAT_ERR_OK;
+}
+
+
 static void *bench_run_4k_fn(struct vmops_bench_run_arg *args)
 {
     plat_error_t err;
 
     struct vmops_bench_cfg *cfg = args->cfg;
 
-    size_t counter = 0;
-
-
     plat_time_t t_delta = plat_convert_time(args->cfg->time_ms);
     if (t_delta == 0) {
         t_delta = PLAT_TIME_MAX;
@@ -141,110 +295,98 @@ static void *bench_run_4k_fn(struct vmops_bench_run_arg *args)
         nops = SIZE_MAX;
     }
 
-    size_t nmaps = cfg->memsize / PLAT_ARCH_BASE_PAGE_SIZE;
-    void **addrs = calloc(nmaps, sizeof(void *));
-    if (addrs == NULL) {
-        LOG_ERR("thread %d malloc failed!\n", args->tid);
+    size_t memsize = cfg->memsize;
+    size_t batchsize = cfg->unmap_batch * plat_page_size(cfg->pages);
+    size_t nbatches = memsize / batchsize;
+
+    void *taddr;
+    err = plat_vm_map(&taddr, memsize, args->memobj, 0, cfg->pages);
+    if (err != PLAT_ERR_OK) {
+        LOG_ERR("thread %d. failed to map memory!\n", args->tid);
         return NULL;
     }
 
+    bool victim;
+    if (!tlbshoot_role(args, &victim)) {
+        return tlbshoot_background_run(args, taddr, victim);
+    }
+
+    /* the batches replace the large mapping, or are placed in the thread's isolated region */
+    void *base = taddr;
     if (cfg->isolated) {
-        void *addr = utils_vmops_get_map_address(args->tid);
-        for (size_t i = 0; i < nmaps; i++) {
-            err = plat_vm_map_fixed(addr, PLAT_ARCH_BASE_PAGE_SIZE, args->memobj,
-                                    i * PLAT_ARCH_BASE_PAGE_SIZE, cfg->maphuge);
-            if (err != PLAT_ERR_OK) {
-                LOG_ERR("thread %d. failed to map memory i=%zu!\n", args->tid, i);
-                goto cleanup_and_exit;
-            }
-            addrs[i] = addr;
+        plat_vm_unmap(taddr, memsize);
+        base = utils_vmops_get_map_address(args->tid);
+    }
 
-            addr = (void *)((uintptr_t)addr + PLAT_ARCH_BASE_PAGE_SIZE);
-        }
-    } else {
-        for (size_t i = 0; i < nmaps; i++) {
-            err = plat_vm_map(&addrs[i], PLAT_ARCH_BASE_PAGE_SIZE, args->memobj,
-                              i * PLAT_ARCH_BASE_PAGE_SIZE, cfg->maphuge);
-            if (err != PLAT_ERR_OK) {
-                LOG_ERR("thread %d. failed to map memory i=%zu!\n", args->tid, i);
-                goto cleanup_and_exit;
-            }
+    /* a failed unmapper still joins the window, such that the other threads are not stuck */
+    bool mapped = true;
+    for (size_t i = 0; i < nbatches && mapped; i++) {
+        err = tlbshoot_map_batch(args, base, i);
+        if (err != PLAT_ERR_OK) {
+            LOG_ERR("thread %d. failed to map memory batch=%zu!\n", args->tid, i);
+            mapped = false;
         }
     }
 
-    LOG_INFO("thread %d ready.\n", args->tid);
-    plat_thread_barrier(args->barrier);
-
+    plat_time_t t_current = vmops_utils_window_begin(args);
 
-    plat_time_t t_current = plat_get_time();
     plat_time_t t_end = t_delta == PLAT_TIME_MAX ? PLAT_TIME_MAX : t_current + t_delta;
     plat_time_t t_start = t_current;
+    size_t counter = 0;
 
-    if (cfg->isolated) {
-        size_t page = args->tid;
-        while (t_current < t_end && counter < nops) {
-            size_t idx = (page++) % nmaps;
-            err = plat_vm_unmap(addrs[idx], PLAT_ARCH_BASE_PAGE_SIZE);
-            if (err != PLAT_ERR_OK) {
-                LOG_ERR("thread %d. failed to unmap memory! %p\n", args->tid, addrs[idx]);
-                goto cleanup_and_exit;
-            }
-            err = plat_vm_map_fixed(addrs[idx], PLAT_ARCH_BASE_PAGE_SIZE, args->memobj,
-                                    idx * PLAT_ARCH_BASE_PAGE_SIZE, cfg->maphuge);
-            if (err != PLAT_ERR_OK) {
-                LOG_ERR("thread %d. failed to map fixed memory! %p\n", args->tid, addrs[idx]);
-                goto cleanup_and_exit;
-            }
-            t_current = plat_get_time();
-            counter++;
-        }
-    } else {
-        size_t page = args->tid;
-        while (t_current < t_end && counter < nops) {
-            size_t idx = (page++) % nmaps;
-            err = plat_vm_unmap(addrs[idx], PLAT_ARCH_BASE_PAGE_SIZE);
-            if (err != PLAT_ERR_OK) {
-                LOG_ERR("thread %d. failed to unmap memory! %p\n", args->tid, addrs[idx]);
-                goto cleanup_and_exit;
-            }
-            err = plat_vm_map(&addrs[idx], PLAT_ARCH_BASE_PAGE_SIZE, args->memobj,
-                              idx * PLAT_ARCH_BASE_PAGE_SIZE, cfg->maphuge);
-            if (err != PLAT_ERR_OK) {
-                LOG_ERR("thread %d. failed to map memory!\n", args->tid);
-                goto cleanup_and_exit;
-            }
-            t_current = plat_get_time();
-            counter++;
+    /* the unmappers start at different batches */
+    size_t batch = args->tid;
+    while (mapped && t_current < t_end && counter < nops) {
+        size_t idx = (batch++) % nbatches;
+        void *addr = (void *)((uintptr_t)base + idx * batchsize);
+
+        plat_time_t t_op_start = vmops_utils_op_start(&args->stats, t_current);
+
+        /* all pages of the batch are unmapped with a single call */
+        err = plat_vm_unmap(addr, batchsize);
+        if (err != PLAT_ERR_OK) {
+            LOG_ERR("thread %d. failed to unmap memory! %p\n", args->tid, addr);
+            goto err_out;
         }
-    }
 
-    t_end = plat_get_time();
+        plat_time_t t_unmap_end = plat_get_time();
 
-    args->count = counter;
-    args->duration = plat_time_to_ms(t_end - t_start);
+        err = tlbshoot_map_batch(args, base, idx);
+        if (err != PLAT_ERR_OK) {
+            LOG_ERR("thread %d. failed to map memory! %p\n", args->tid, addr);
+            goto err_out;
+        }
 
-cleanup_and_exit:
+        t_current = plat_get_time();
 
-    plat_thread_barrier(args->barrier);
+        vmops_utils_add_stats(&args->stats, VMOPS_OP_UNMAP, args->tid, counter,
+                              t_unmap_end - t_start, t_unmap_end - t_op_start);
+        vmops_utils_add_stats(&args->stats, VMOPS_OP_MAP, args->tid, counter,
+                              t_current - t_start, t_current - t_unmap_end);
 
-    for (size_t i = 0; i < nmaps; i++) {
-        if (addrs[i] != NULL) {
-            err = plat_vm_unmap(addrs[i], PLAT_ARCH_BASE_PAGE_SIZE);
-            if (err != PLAT_ERR_OK) {
-                LOG_ERR("thread %d. failed to unmap memory!\n", args->tid);
-            }
-        }
+        counter++;
+        vmops_utils_warmup(args, t_current, &counter, &t_start, &t_end);
+    }
+    t_end = plat_get_time();
+
+    if (!mapped) {
+        goto err_out;
     }
 
-    free(addrs);
+    args->count = counter;
+    args->duration = plat_time_to_ms(t_end - t_start);
+
+err_out:
+    tlbshoot_unmapper_done(args);
 
-    plat_thread_barrier(args->barrier);
+    vmops_utils_window_end(args);
 
     LOG_INFO("thread %d done. ops = %zu, time=%.3f\n", args->tid, counter, args->duration);
 
+    plat_vm_unmap(base, memsize);
+
     return NULL;
 }
-#endif
 
 /**
  * @brief starts the tlbshootdown benchmark
@@ -261,32 +403,82 @@ int vmops_bench_run_tlbshoot(struct vmops_bench_cfg *cfg, const char *opts)
         return -1;
     }
 
+    if (cfg->victims < 0) {
+        cfg->victims = cfg->corelist_size > cfg->unmappers ? cfg->corelist_size - cfg->unmappers
+                                                           : 0;
+    }
+
+    if (cfg->unmappers == 0 || cfg->unmappers + cfg->victims > cfg->corelist_size) {
+        LOG_ERR("need at least one unmapper and at most %u unmappers and victims\n",
+                cfg->corelist_size);
+        return -1;
+    }
+
+    size_t pagesize = plat_page_size(cfg->pages);
+    if (cfg->victim_pages == 0 || cfg->victim_pages > cfg->memsize / pagesize) {
+        LOG_ERR("victims can touch 1 to %zu pages of the memory size\n",
+                cfg->memsize / pagesize);
+        return -1;
+    }
+
+    if (cfg->map4k && (cfg->unmap_batch == 0
+                       || cfg->unmap_batch > cfg->memsize / pagesize)) {
+        LOG_ERR("the unmap batch must hold 1 to %zu pages of the memory size\n",
+                cfg->memsize / pagesize);
+        return -1;
+    }
+
     LOG_INFO("Preparing benchmark. 'map/unmap' with options '%s'\n",
              vmops_utils_print_options(cfg));
+    LOG_INFO("%u unmappers, %d victims touching %u pages each\n", cfg->unmappers,
+             cfg->victims, cfg->victim_pages);
+    if (cfg->map4k) {
+        LOG_INFO("unmapping batches of %u pages mapped %s\n", cfg->unmap_batch,
+                 cfg->ranged ? "as one range" : "one by one");
+    }
+
+    /* the state is shared with the benchmark processes */
+    struct tlbshoot_state *st;
+    if (plat_mem_alloc(sizeof(struct tlbshoot_state), (void **)&st) != PLAT_ERR_OK) {
+        LOG_ERR("failed to allocate the shared state\n");
+        return -1;
+    }
 
-    uint64_t done = 0;
     struct vmops_bench_run_arg *args;
-    if (vmops_utils_prepare_args(cfg, (void *)&done, &args)) {
+    if (vmops_utils_prepare_args(cfg, (void *)st, &args)) {
         LOG_ERR("failed to prepare arguments\n");
+        plat_mem_free(st, sizeof(struct tlbshoot_state));
         return -1;
     }
 
 
     plat_thread_fn_t run_fn = bench_run_fn;
     if (cfg->map4k) {
-        run_fn = bench_run_fn;
+        run_fn = bench_run_4k_fn;
     } else {
         run_fn = bench_run_fn;
     }
 
     if (vmops_utils_run_benchmark(cfg->corelist_size, args, run_fn)) {
         LOG_ERR("failed to run the benchmark\n");
+        plat_mem_free(st, sizeof(struct tlbshoot_state));
         return -1;
     }
 
     vmops_utils_print_csv(args);
 
+    /* the access throughput of the victims, while their TLBs were shot down */
+    size_t accesses = 0;
+    double thpt = 0;
+    for (uint32_t i = cfg->unmappers; i < cfg->unmappers + cfg->victims; i++) {
+        accesses += args[i].count;
+        thpt += args[i].duration > 0 ? args[i].count * 1000.0 / args[i].duration : 0;
+    }
+    LOG_RESULT_VICTIMS(cfg->benchmark, cfg->unmappers, cfg->victims, cfg->victim_pages, accesses,
+                       thpt);
+
     vmops_utils_cleanup_args(args);
+    plat_mem_free(st, sizeof(struct tlbshoot_state));
 
     return 0;
 }
\ No newline at end of file
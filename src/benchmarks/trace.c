@@ -0,0 +1,375 @@
+/*
+ * Virtual Memory Operations Benchmark
+ *
+ * Copyright 2020 Reto Achermann
+ * SPDX-License-Identifier: GPL-3.0
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "trace.h"
+#include "utils.h"
+
+
+struct vmops_trace
+{
+    struct vmops_bench_run_arg arg;   ///< the arguments of the writer thread
+    struct vmops_trace_ring *rings;   ///< the rings of the benchmark threads
+    uint32_t nrings;                  ///< the number of rings
+    bool done;                        ///< set when the benchmark threads have exited
+    FILE *file;                       ///< the trace file
+    const char *path;                 ///< the path of the trace file
+    struct vmops_trace_header header; ///< the header of the trace file
+};
+
+
+/*
+ * ================================================================================================
+ * Trace Capture
+ * ================================================================================================
+ */
+
+
+/**
+ * @brief creates the trace file and the rings of the benchmark threads
+ *
+ * @param path  the path of the trace file
+ * @param cfg   the benchmark configuration, stored in the trace header
+ *
+ * @returns the trace state, NULL on failure
+ */
+struct vmops_trace *vmops_trace_open(const char *path, struct vmops_bench_cfg *cfg)
+{
+    if (cfg->corelist_size > VMOPS_TRACE_MAX_CORES) {
+        LOG_ERR("trace supports at most %d threads\n", VMOPS_TRACE_MAX_CORES);
+        return NULL;
+    }
+
+    struct vmops_trace *trace = aligned_alloc(_Alignof(struct vmops_trace),
+                                              sizeof(struct vmops_trace));
+    if (trace == NULL) {
+        return NULL;
+    }
+    memset(trace, 0, sizeof(struct vmops_trace));
+
+    /* the rings are shared with the benchmark processes, the allocation is zeroed */
+    trace->nrings = cfg->corelist_size;
+    if (plat_mem_alloc(trace->nrings * sizeof(struct vmops_trace_ring), (void **)&trace->rings)
+        != PLAT_ERR_OK) {
+        LOG_ERR("could not allocate the trace rings\n");
+        trace->rings = NULL;
+        goto err_out;
+    }
+
+    trace->path = path;
+    trace->file = fopen(path, "w");
+    if (trace->file == NULL) {
+        LOG_ERR("could not open trace file '%s'\n", path);
+        goto err_out;
+    }
+
+    struct vmops_trace_header *hdr = &trace->header;
+    memcpy(hdr->magic, VMOPS_TRACE_MAGIC, sizeof(hdr->magic));
+    hdr->version = VMOPS_TRACE_VERSION;
+    hdr->record_size = sizeof(struct statval);
+    hdr->data_offset = VMOPS_TRACE_DATA_OFFSET;
+    hdr->ticks_per_sec = plat_convert_time(1000);
+    hdr->memsize = cfg->memsize;
+    hdr->flags = (cfg->numainterleave ? VMOPS_TRACE_FLAG_NUMAINTERLEAVE : 0)
+                 | (cfg->map4k ? VMOPS_TRACE_FLAG_MAP4K : 0)
+                 | (cfg->pages == PLAT_PAGE_HUGE_2M ? VMOPS_TRACE_FLAG_MAPHUGE : 0)
+                 | (cfg->shared ? VMOPS_TRACE_FLAG_SHARED : 0)
+                 | (cfg->isolated ? VMOPS_TRACE_FLAG_ISOLATED : 0)
+                 | ((uint32_t)cfg->memobj << VMOPS_TRACE_FLAG_MEMOBJ_SHIFT)
+                 | ((uint32_t)cfg->pages << VMOPS_TRACE_FLAG_PAGES_SHIFT);
+    hdr->page_size = cfg->page_size;
+    hdr->ncores = cfg->corelist_size;
+    strncpy(hdr->benchmark, cfg->benchmark, sizeof(hdr->benchmark) - 1);
+    memcpy(hdr->coreslist, cfg->coreslist, cfg->corelist_size * sizeof(uint32_t));
+
+    /* the header is rewritten with the final counts when the trace is closed */
+    static const char zeros[VMOPS_TRACE_DATA_OFFSET];
+    if (fwrite(zeros, sizeof(zeros), 1, trace->file) != 1) {
+        LOG_ERR("could not write trace file header\n");
+        goto err_out;
+    }
+
+    trace->arg.cfg = cfg;
+    trace->arg.tid = trace->nrings;
+    trace->arg.shared = trace;
+
+    LOG_INFO("tracing latencies to '%s'\n", path);
+
+    return trace;
+
+err_out:
+    if (trace->file != NULL) {
+        fclose(trace->file);
+    }
+    plat_mem_free(trace->rings, trace->nrings * sizeof(struct vmops_trace_ring));
+    free(trace);
+    return NULL;
+}
+
+
+/**
+ * @brief obtains the ring of a benchmark thread
+ *
+ * @param trace the trace state
+ * @param tid   the id of the benchmark thread
+ *
+ * @returns the ring of the thread
+ */
+struct vmops_trace_ring *vmops_trace_ring(struct vmops_trace *trace, uint32_t tid)
+{
+    return &trace->rings[tid];
+}
+
+
+/**
+ * @brief writes the samples that are currently in a ring to the trace file
+ *
+ * @param trace the trace state
+ * @param ring  the ring to be drained
+ *
+ * @returns the number of samples written
+ */
+static uint64_t trace_drain(struct vmops_trace *trace, struct vmops_trace_ring *ring)
+{
+    uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint64_t tail = ring->tail;
+    uint64_t written = 0;
+
+    while (tail < head) {
+        /* write the contiguous part up to the end of the slot array at once */
+        uint64_t idx = tail & (VMOPS_TRACE_RING_SIZE - 1);
+        uint64_t n = head - tail;
+        if (n > VMOPS_TRACE_RING_SIZE - idx) {
+            n = VMOPS_TRACE_RING_SIZE - idx;
+        }
+
+        if (fwrite(&ring->slots[idx], sizeof(struct statval), n, trace->file) != n) {
+            LOG_ERR("failed to write to the trace file\n");
+        }
+
+        tail += n;
+        written += n;
+        __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+    }
+
+    return written;
+}
+
+
+/**
+ * @brief drains the rings of all benchmark threads until the trace is stopped
+ *
+ * @param arg   the arguments of the writer thread
+ *
+ * @returns NULL
+ */
+static void *trace_writer_run_fn(struct vmops_bench_run_arg *arg)
+{
+    struct vmops_trace *trace = (struct vmops_trace *)arg->shared;
+
+    bool done;
+    do {
+        done = __atomic_load_n(&trace->done, __ATOMIC_ACQUIRE);
+
+        /* after the threads have exited, one pass drains the remaining samples */
+        uint64_t written = 0;
+        for (uint32_t i = 0; i < trace->nrings; i++) {
+            written += trace_drain(trace, &trace->rings[i]);
+        }
+        trace->header.nrecords += written;
+
+        if (written == 0 && !done) {
+            plat_usleep(VMOPS_TRACE_WRITER_SLEEP_US);
+        }
+    } while (!done);
+
+    return NULL;
+}
+
+
+/**
+ * @brief starts the writer thread that drains the rings into the trace file
+ *
+ * @param trace the trace state
+ * @param core  the core to run the writer thread on
+ *
+ * @returns 0 on success, -1 on failure
+ */
+int vmops_trace_start(struct vmops_trace *trace, uint32_t core)
+{
+    trace->done = false;
+    trace->arg.coreid = core;
+
+    LOG_INFO("trace writer thread on core %d\n", core);
+
+    trace->arg.thread = plat_thread_start(trace_writer_run_fn, &trace->arg, core);
+    if (trace->arg.thread == NULL) {
+        LOG_ERR("failed to start the trace writer thread\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+
+/**
+ * @brief stops the writer thread after it has drained the rings
+ *
+ * @param trace the trace state
+ */
+void vmops_trace_stop(struct vmops_trace *trace)
+{
+    if (trace->arg.thread == NULL) {
+        return;
+    }
+
+    __atomic_store_n(&trace->done, true, __ATOMIC_RELEASE);
+    plat_thread_join(trace->arg.thread);
+    trace->arg.thread = NULL;
+}
+
+
+/**
+ * @brief finalizes the trace file and frees the trace state
+ *
+ * @param trace the trace state
+ */
+void vmops_trace_close(struct vmops_trace *trace)
+{
+    if (trace == NULL) {
+        return;
+    }
+
+    vmops_trace_stop(trace);
+
+    for (uint32_t i = 0; i < trace->nrings; i++) {
+        trace->header.dropped += trace->rings[i].dropped;
+    }
+
+    if (trace->header.dropped) {
+        LOG_WARN("trace writer could not keep up. dropped %" PRIu64 " samples\n",
+                 trace->header.dropped);
+    }
+
+    LOG_INFO("wrote %" PRIu64 " samples to '%s'\n", trace->header.nrecords, trace->path);
+
+    rewind(trace->file);
+    if (fwrite(&trace->header, sizeof(trace->header), 1, trace->file) != 1) {
+        LOG_ERR("could not write trace file header\n");
+    }
+    fclose(trace->file);
+
+    plat_mem_free(trace->rings, trace->nrings * sizeof(struct vmops_trace_ring));
+    free(trace);
+}
+
+
+/*
+ * ================================================================================================
+ * Trace Decoding
+ * ================================================================================================
+ */
+
+
+///< the number of samples that are decoded at once
+#define TRACE_DECODE_BATCH 4096
+
+
+/**
+ * @brief converts a trace file into the latency csv
+ *
+ * @param path  the path of the trace file
+ *
+ * @returns 0 on success, -1 on failure
+ */
+int vmops_trace_decode(const char *path)
+{
+    _Static_assert(sizeof(struct vmops_trace_header) <= VMOPS_TRACE_DATA_OFFSET,
+                   "trace header exceeds the data offset");
+
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        LOG_ERR("could not open trace file '%s'\n", path);
+        return -1;
+    }
+
+    struct vmops_trace_header hdr;
+    if (fread(&hdr, sizeof(hdr), 1, f) != 1 || memcmp(hdr.magic, VMOPS_TRACE_MAGIC, 8) != 0) {
+        LOG_ERR("'%s' is not a trace file\n", path);
+        fclose(f);
+        return -1;
+    }
+
+    if (hdr.version != VMOPS_TRACE_VERSION || hdr.record_size != sizeof(struct statval)
+        || hdr.ncores > VMOPS_TRACE_MAX_CORES || hdr.ticks_per_sec == 0) {
+        LOG_ERR("unsupported trace file version %u\n", hdr.version);
+        fclose(f);
+        return -1;
+    }
+
+    if (fseek(f, hdr.data_offset, SEEK_SET) != 0) {
+        fclose(f);
+        return -1;
+    }
+
+    hdr.benchmark[sizeof(hdr.benchmark) - 1] = 0;
+
+    /* reconstruct the configuration the csv columns are printed from */
+    struct vmops_bench_cfg cfg = { 0 };
+    cfg.benchmark = hdr.benchmark;
+    cfg.coreslist = hdr.coreslist;
+    cfg.corelist_size = hdr.ncores;
+    cfg.memsize = hdr.memsize;
+    cfg.numainterleave = hdr.flags & VMOPS_TRACE_FLAG_NUMAINTERLEAVE;
+    cfg.map4k = hdr.flags & VMOPS_TRACE_FLAG_MAP4K;
+    cfg.shared = hdr.flags & VMOPS_TRACE_FLAG_SHARED;
+    cfg.isolated = hdr.flags & VMOPS_TRACE_FLAG_ISOLATED;
+    cfg.memobj = (hdr.flags & VMOPS_TRACE_FLAG_MEMOBJ_MASK) >> VMOPS_TRACE_FLAG_MEMOBJ_SHIFT;
+    cfg.pages = (hdr.flags & VMOPS_TRACE_FLAG_PAGES_MASK) >> VMOPS_TRACE_FLAG_PAGES_SHIFT;
+    cfg.page_size = hdr.page_size;
+
+    /* traces without the pages only flag the 2M huge pages */
+    if (cfg.pages == PLAT_PAGE_BASE && (hdr.flags & VMOPS_TRACE_FLAG_MAPHUGE)) {
+        cfg.pages = PLAT_PAGE_HUGE_2M;
+    }
+
+    LOG_INFO("decoding %" PRIu64 " samples of '%s' from '%s'\n", hdr.nrecords, cfg.benchmark,
+             path);
+    if (hdr.dropped) {
+        LOG_WARN("the trace is missing %" PRIu64 " dropped samples\n", hdr.dropped);
+    }
+
+    struct statval *batch = malloc(TRACE_DECODE_BATCH * sizeof(struct statval));
+    if (batch == NULL) {
+        fclose(f);
+        return -1;
+    }
+
+    double ms_per_tick = 1000.0 / (double)hdr.ticks_per_sec;
+
+    LOG_STATS_HEADER();
+
+    size_t n;
+    while ((n = fread(batch, sizeof(struct statval), TRACE_DECODE_BATCH, f)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            if (batch[i].tid >= hdr.ncores || batch[i].op >= VMOPS_OP_MAX) {
+                continue;
+            }
+            LOG_STATS_MS(&cfg, batch[i], batch[i].t_elapsed * ms_per_tick,
+                         batch[i].val * ms_per_tick);
+        }
+    }
+
+    LOG_STATS_FOOTER();
+
+    free(batch);
+    fclose(f);
+
+    return 0;
+}
@@ -0,0 +1,197 @@
+/*
+ * Virtual Memory Operations Benchmark
+ *
+ * Copyright 2020 Reto Achermann
+ * SPDX-License-Identifier: GPL-3.0
+ */
+
+#ifndef __VMOPS_TRACE_H_
+#define __VMOPS_TRACE_H_ 1
+
+#include "benchmarks.h"
+
+
+/*
+ * ================================================================================================
+ * Latency Trace File Format
+ * ================================================================================================
+ *
+ * The trace file starts with a header holding the benchmark configuration, padded to
+ * VMOPS_TRACE_DATA_OFFSET. It is followed by the samples of all threads as struct statval
+ * records in the order they were drained from the rings.
+ */
+
+
+///< identifies a latency trace file
+#define VMOPS_TRACE_MAGIC "VMOPSTRC"
+
+///< the version of the trace file format
+#define VMOPS_TRACE_VERSION 1
+
+///< the maximum number of cores stored in the trace header
+#define VMOPS_TRACE_MAX_CORES 512
+
+///< the offset of the first sample in the trace file
+#define VMOPS_TRACE_DATA_OFFSET 4096
+
+///< flags of the benchmark configuration stored in the trace header
+#define VMOPS_TRACE_FLAG_NUMAINTERLEAVE (1U << 0)
+#define VMOPS_TRACE_FLAG_MAP4K (1U << 1)
+#define VMOPS_TRACE_FLAG_MAPHUGE (1U << 2)
+#define VMOPS_TRACE_FLAG_SHARED (1U << 3)
+#define VMOPS_TRACE_FLAG_ISOLATED (1U << 4)
+
+///< the memory object backend stored in the flags of the trace header
+#define VMOPS_TRACE_FLAG_MEMOBJ_SHIFT 8
+#define VMOPS_TRACE_FLAG_MEMOBJ_MASK (0xffU << VMOPS_TRACE_FLAG_MEMOBJ_SHIFT)
+
+///< the requested pages stored in the flags of the trace header
+#define VMOPS_TRACE_FLAG_PAGES_SHIFT 16
+#define VMOPS_TRACE_FLAG_PAGES_MASK (0xffU << VMOPS_TRACE_FLAG_PAGES_SHIFT)
+
+struct vmops_trace_header
+{
+    char magic[8];                              ///< VMOPS_TRACE_MAGIC
+    uint32_t version;                           ///< VMOPS_TRACE_VERSION
+    uint32_t record_size;                       ///< the size of a sample record
+    uint64_t data_offset;                       ///< the file offset of the first sample
+    uint64_t nrecords;                          ///< the number of samples in the file
+    uint64_t dropped;                           ///< the number of samples lost on full rings
+    uint64_t ticks_per_sec;                     ///< the resolution of the time values
+    uint64_t memsize;                           ///< the memory size of the benchmark
+    uint32_t flags;                             ///< VMOPS_TRACE_FLAG_* of the benchmark
+    uint32_t ncores;                            ///< the number of benchmark threads
+    char benchmark[64];                         ///< the name of the benchmark
+    uint32_t coreslist[VMOPS_TRACE_MAX_CORES];  ///< the core of each benchmark thread
+    uint64_t page_size;                         ///< the page size reported by the kernel
+};
+
+
+/*
+ * ================================================================================================
+ * Per-Thread Sample Rings
+ * ================================================================================================
+ */
+
+
+///< the number of samples per ring, must be a power of two
+#define VMOPS_TRACE_RING_SIZE (1UL << 16)
+
+///< the time the writer sleeps when all rings are empty
+#define VMOPS_TRACE_WRITER_SLEEP_US 1000
+
+///< single-producer single-consumer ring between a benchmark thread and the writer thread
+struct vmops_trace_ring
+{
+    ///< the next slot to be written, only updated by the producer
+    uint64_t head __attribute__((aligned(PLAT_ARCH_CACHELINE_SIZE)));
+    ///< the producer's last known value of the tail
+    uint64_t tail_cached;
+    ///< the number of samples dropped because the ring was full
+    uint64_t dropped;
+    ///< the next slot to be read, only updated by the consumer
+    uint64_t tail __attribute__((aligned(PLAT_ARCH_CACHELINE_SIZE)));
+    ///< the sample slots
+    struct statval slots[VMOPS_TRACE_RING_SIZE]
+        __attribute__((aligned(PLAT_ARCH_CACHELINE_SIZE)));
+};
+
+
+/**
+ * @brief adds a sample to the ring of the calling thread
+ *
+ * @param ring      the ring of the calling thread
+ * @param sample    the sample to be added
+ *
+ * The sample is dropped and accounted if the writer has not yet drained a full ring.
+ */
+static inline void vmops_trace_push(struct vmops_trace_ring *ring, const struct statval *sample)
+{
+    uint64_t head = ring->head;
+
+    if (head - ring->tail_cached == VMOPS_TRACE_RING_SIZE) {
+        ring->tail_cached = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+        if (head - ring->tail_cached == VMOPS_TRACE_RING_SIZE) {
+            ring->dropped++;
+            return;
+        }
+    }
+
+    ring->slots[head & (VMOPS_TRACE_RING_SIZE - 1)] = *sample;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+
+/*
+ * ================================================================================================
+ * Trace Capture and Decoding
+ * ================================================================================================
+ */
+
+
+///< state of a latency trace capture
+struct vmops_trace;
+
+
+/**
+ * @brief creates the trace file and the rings of the benchmark threads
+ *
+ * @param path  the path of the trace file
+ * @param cfg   the benchmark configuration, stored in the trace header
+ *
+ * @returns the trace state, NULL on failure
+ */
+struct vmops_trace *vmops_trace_open(const char *path, struct vmops_bench_cfg *cfg);
+
+
+/**
+ * @brief obtains the ring of a benchmark thread
+ *
+ * @param trace the trace state
+ * @param tid   the id of the benchmark thread
+ *
+ * @returns the ring of the thread
+ */
+struct vmops_trace_ring *vmops_trace_ring(struct vmops_trace *trace, uint32_t tid);
+
+
+/**
+ * @brief starts the writer thread that drains the rings into the trace file
+ *
+ * @param trace the trace state
+ * @param core  the core to run the writer thread on
+ *
+ * @returns 0 on success, -1 on failure
+ */
+int vmops_trace_start(struct vmops_trace *trace, uint32_t core);
+
+
+/**
+ * @brief stops the writer thread after it has drained the rings
+ *
+ * @param trace the trace state
+ *
+ * The benchmark threads must not add any further samples.
+ */
+void vmops_trace_stop(struct vmops_trace *trace);
+
+
+/**
+ * @brief finalizes the trace file and frees the trace state
+ *
+ * @param trace the trace state
+ */
+void vmops_trace_close(struct vmops_trace *trace);
+
+
+/**
+ * @brief converts a trace file into the latency csv
+ *
+ * @param path  the path of the trace file
+ *
+ * @returns 0 on success, -1 on failure
+ */
+int vmops_trace_decode(const char *path);
+
+
+#endif /* __VMOPS_TRACE_H_ */
@@ -6,13 +6,16 @@
  */
 
 #include <string.h>
+#include <math.h>
 
 #include "../platform/platform.h"
 #include "../logging.h"
 #include "utils.h"
+#include "report.h"
 
 #define VMOBJ_NAME_SHARED "/vmops_bench_shared"
 #define VMOBJ_NAME_INDEPENDENT "/vmops_bench_independent_%d"
+#define VMOBJ_NAME_POPULATION "/vmops_bench_population"
 
 
 /*
@@ -37,6 +40,8 @@ int vmops_utils_parse_options(const char *opts, struct vmops_bench_cfg *cfg)
     bool independent = false;
     bool isolated = false;
     bool map4k = false;
+    bool ranged = false;
+    bool processes = false;
 
     while (*current) {
         if (strncmp(current, "-shared", 7) == 0) {
@@ -51,6 +56,12 @@ int vmops_utils_parse_options(const char *opts, struct vmops_bench_cfg *cfg)
         } else if (strncmp(current, "-isolated", 9) == 0) {
             current += 9;
             isolated = true;
+        } else if (strncmp(current, "-ranged", 7) == 0) {
+            current += 7;
+            ranged = true;
+        } else if (strncmp(current, "-process", 8) == 0) {
+            current += 8;
+            processes = true;
         } else {
             LOG_ERR("unknown option '%s'\n", current);
             return -1;
@@ -69,6 +80,8 @@ int vmops_utils_parse_options(const char *opts, struct vmops_bench_cfg *cfg)
     cfg->shared = shared;
     cfg->isolated = isolated;
     cfg->map4k = map4k;
+    cfg->ranged = ranged;
+    cfg->processes = processes;
 
     return 0;
 }
@@ -85,9 +98,10 @@ char *vmops_utils_print_options(struct vmops_bench_cfg *cfg)
 {
     static char optbuf[256];
 
-    snprintf(optbuf, sizeof(optbuf), "%s%s, %s, %s", cfg->nounmap ? "nounmap, " : "",
+    snprintf(optbuf, sizeof(optbuf), "%s%s, %s, %s%s%s", cfg->nounmap ? "nounmap, " : "",
              cfg->shared ? "shared" : "independent", cfg->isolated ? "isolated" : "default",
-             cfg->map4k ? "many 4k mappings" : "one large mapping");
+             cfg->map4k ? "many 4k mappings" : "one large mapping",
+             cfg->ranged ? ", ranged" : "", cfg->processes ? ", processes" : "");
 
     return optbuf;
 }
@@ -100,6 +114,158 @@ char *vmops_utils_print_options(struct vmops_bench_cfg *cfg)
  */
 
 
+/**
+ * @brief obtains the name of an operation type
+ *
+ * @param op    the operation type
+ *
+ * @returns string representation of the operation
+ */
+const char *vmops_utils_op_name(vmops_op_t op)
+{
+    switch (op) {
+    case VMOPS_OP_MAP:
+        return "map";
+    case VMOPS_OP_UNMAP:
+        return "unmap";
+    case VMOPS_OP_PROTECT:
+        return "protect";
+    case VMOPS_OP_FAULT:
+        return "fault";
+    case VMOPS_OP_DISCARD:
+        return "discard";
+    case VMOPS_OP_REMAP:
+        return "remap";
+    case VMOPS_OP_DIRTY:
+        return "dirty";
+    case VMOPS_OP_SYNC:
+        return "msync";
+    case VMOPS_OP_SPLIT:
+        return "split";
+    case VMOPS_OP_MERGE:
+        return "merge";
+    default:
+        return "unknown";
+    }
+}
+
+
+///< the names of the memory object backends, as used on the command line
+static const char *utils_memobj_types[PLAT_MEMOBJ_MAX] = {
+    [PLAT_MEMOBJ_MEMFD] = "memfd",
+    [PLAT_MEMOBJ_ANON_PRIVATE] = "anon",
+    [PLAT_MEMOBJ_ANON_SHARED] = "anonshared",
+    [PLAT_MEMOBJ_SHM] = "shm",
+    [PLAT_MEMOBJ_FILE] = "file",
+    [PLAT_MEMOBJ_FILE_PREALLOC] = "filealloc",
+};
+
+
+/**
+ * @brief parses the name of a memory object backend
+ *
+ * @param name  the name of the backend
+ * @param type  returns the backend
+ *
+ * @returns 0 on success, -1 if the name is unknown
+ */
+int vmops_utils_parse_memobj(const char *name, plat_memobj_type_t *type)
+{
+    for (uint32_t i = 0; i < PLAT_MEMOBJ_MAX; i++) {
+        if (strcmp(name, utils_memobj_types[i]) == 0) {
+            *type = (plat_memobj_type_t)i;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+
+/**
+ * @brief obtains the name of the memory objects of the benchmark for the csv
+ *
+ * @param cfg   the benchmark configuration
+ *
+ * @returns the sharing and the backend of the memory objects
+ */
+const char *vmops_utils_memobj_name(struct vmops_bench_cfg *cfg)
+{
+    static char name[32];
+
+    if (cfg->memobj >= PLAT_MEMOBJ_MAX) {
+        return "unknown";
+    }
+
+    snprintf(name, sizeof(name), "%s-%s", cfg->shared ? "shared" : "independent",
+             utils_memobj_types[cfg->memobj]);
+
+    return name;
+}
+
+
+///< the names of the page sizes, as used on the command line
+static const char *utils_page_types[PLAT_PAGE_MAX] = {
+    [PLAT_PAGE_BASE] = "4k",
+    [PLAT_PAGE_HUGE_2M] = "2m",
+    [PLAT_PAGE_HUGE_1G] = "1g",
+    [PLAT_PAGE_THP] = "thp",
+};
+
+
+/**
+ * @brief parses the name of a page size
+ *
+ * @param name  the name of the page size
+ * @param page  returns the pages
+ *
+ * @returns 0 on success, -1 if the name is unknown
+ */
+int vmops_utils_parse_pages(const char *name, plat_page_t *page)
+{
+    for (uint32_t i = 0; i < PLAT_PAGE_MAX; i++) {
+        if (strcmp(name, utils_page_types[i]) == 0) {
+            *page = (plat_page_t)i;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+
+/**
+ * @brief obtains the name of the page size of the benchmark for the csv
+ *
+ * @param cfg   the benchmark configuration
+ *
+ * @returns the size of the pages the kernel backed the mappings with
+ *
+ * Falls back to the requested page size if the kernel did not report it. Transparent huge
+ * pages are prefixed with 'thp-' to tell them apart from the huge page pool.
+ */
+const char *vmops_utils_page_size_name(struct vmops_bench_cfg *cfg)
+{
+    static char name[32];
+
+    if (cfg->pages >= PLAT_PAGE_MAX) {
+        return "unknown";
+    }
+
+    size_t size = cfg->page_size ? cfg->page_size : plat_page_size(cfg->pages);
+    const char *prefix = cfg->pages == PLAT_PAGE_THP ? "thp-" : "";
+    if (size >= PLAT_ARCH_GIANT_PAGE_SIZE) {
+        snprintf(name, sizeof(name), "%s%zug", prefix, size >> 30);
+    } else if (size >= PLAT_ARCH_HUGE_PAGE_SIZE) {
+        snprintf(name, sizeof(name), "%s%zum", prefix, size >> 20);
+    } else {
+        snprintf(name, sizeof(name), "%s%zuk", prefix, size >> 10);
+    }
+
+    return name;
+}
+
+
 #if 0
 static int paircmp(const void *_p1, const void *_p2)
 {
@@ -132,6 +298,11 @@ void vmops_utils_print_csv(struct vmops_bench_run_arg *args)
 
     size_t total_ops = 0;
     double total_time = 0;
+    double thpt = 0;
+    uint64_t total_ipis = 0;
+
+    /* the interrupts received during the measured window, if they were accounted */
+    struct plat_irqcounts *irq = args->irqcounts != NULL ? &args->irqcounts[1] : NULL;
 
     LOG_CSV_HEADER();
     for (uint32_t i = 0; i < cfg->corelist_size; i++) {
@@ -140,29 +311,215 @@ void vmops_utils_print_csv(struct vmops_bench_run_arg *args)
             exit(EXIT_FAILURE);
         }
 
-        LOG_CSV(cfg, i, args[i].duration, args[i].count);
+        uint64_t *ipis = NULL;
+        if (irq != NULL && cfg->coreslist[i] < PLAT_IRQSTATS_MAX_CORES) {
+            ipis = irq->ipis[cfg->coreslist[i]];
+        }
+
+        LOG_CSV(cfg, i, args[i].duration, args[i].count, args[i].perfctr_delta, ipis);
 
-        total_ops += args[i].count;
-        total_time += args[i].duration;
+        if (ipis != NULL) {
+            total_ipis += ipis[PLAT_IPI_TLB_SHOOTDOWN] + ipis[PLAT_IPI_FUNCTION_CALL];
+        }
+
+        /* the throughput of the benchmark is the sum of the throughputs of its threads */
+        if (!args[i].background) {
+            total_ops += args[i].count;
+            total_time += args[i].duration;
+            if (args[i].duration > 0) {
+                thpt += args[i].count * 1000.0 / args[i].duration;
+            }
+        }
     }
     LOG_CSV_FOOTER();
 
-    double latency = 0;
+    /* how far the threads were apart when they started the measured window */
+    plat_time_t wake_max = 0;
+    plat_time_t late_max = 0;
+    uint32_t late = 0;
+    for (uint32_t i = 0; i < cfg->corelist_size; i++) {
+        LOG_INFO("thread %d woke up after %.6f ms, started %.6f ms late\n", i,
+                 plat_time_to_ms(args[i].t_wake), plat_time_to_ms(args[i].t_late));
+        wake_max = args[i].t_wake > wake_max ? args[i].t_wake : wake_max;
+        late_max = args[i].t_late > late_max ? args[i].t_late : late_max;
+        late += args[i].t_late > 0;
+    }
+
+    LOG_RESULT_SKEW(cfg->benchmark, plat_time_to_ms(wake_max), plat_time_to_ms(late_max), late,
+                    cfg->corelist_size);
+    if (late) {
+        LOG_WARN("%u threads started late. the window had fewer threads at its start\n", late);
+    }
 
-    struct statval *pairs = args[0].stats.values;
-    if (cfg->stats && pairs) {
-       // qsort(pairs, cfg->stats * cfg->corelist_size, sizeof(struct statval), paircmp);
+    if (irq != NULL) {
+        /* every shootdown interrupt received by any core of the system */
+        uint64_t shootdowns = 0;
+        for (uint32_t i = 0; i < PLAT_IRQSTATS_MAX_CORES; i++) {
+            shootdowns += irq->ipis[i][PLAT_IPI_TLB_SHOOTDOWN];
+        }
+
+        LOG_RESULT_IPI(cfg->benchmark, shootdowns, total_ops, total_ipis, cfg->corelist_size);
+        if (irq->has_tlbflush) {
+            LOG_RESULT_TLBFLUSH(cfg->benchmark, irq->tlbflush);
+        }
+    }
 
+    if (cfg->stats) {
         LOG_STATS_HEADER();
-        for (size_t i = 0; i < cfg->stats * cfg->corelist_size; i++) {
-            LOG_STATS(cfg, i, pairs[i]);
-            latency += plat_time_to_ms(pairs[i].val);
+        for (uint32_t t = 0; t < cfg->corelist_size; t++) {
+            struct statval *pairs = args[t].stats.values;
+            for (size_t i = 0; pairs != NULL && i < cfg->stats; i++) {
+                LOG_STATS(cfg, i, pairs[i]);
+            }
         }
         LOG_STATS_FOOTER();
     }
 
-    LOG_RESULT(cfg->benchmark, cfg->memsize, total_time, cfg->corelist_size, total_ops,
-               (double)(total_ops * 1000) / total_time, latency / total_ops);
+    struct vmops_hist *hist = malloc(2 * sizeof(struct vmops_hist));
+    if (hist == NULL) {
+        LOG_ERR("could not allocate memory for merging the histograms\n");
+        return;
+    }
+
+    /* the first histogram holds all operations, the second one a single operation type */
+    struct vmops_hist *ophist = hist + 1;
+    vmops_hist_reset(hist);
+
+    if (histout != NULL) {
+        LOG_HIST_HEADER();
+    }
+
+    for (uint32_t op = 0; op < VMOPS_OP_MAX; op++) {
+        vmops_hist_reset(ophist);
+        for (uint32_t i = 0; i < cfg->corelist_size; i++) {
+            if (histout != NULL) {
+                LOG_HIST(cfg, (int)i, op, &args[i].stats.hist[op]);
+            }
+            vmops_hist_merge(ophist, &args[i].stats.hist[op]);
+        }
+
+        if (ophist->count == 0) {
+            continue;
+        }
+
+        if (histout != NULL) {
+            LOG_HIST(cfg, -1, op, ophist);
+        }
+
+        LOG_RESULT_OP(cfg->benchmark, vmops_utils_op_name(op), ophist);
+
+        /* the latency as a function of the number of mappings in the address space */
+        if (cfg->population_max) {
+            LOG_RESULT_VMAS(cfg->benchmark, cfg->population, cfg->vmas,
+                            vmops_utils_op_name(op), ophist);
+        }
+
+        vmops_hist_merge(hist, ophist);
+    }
+
+    LOG_RESULT(cfg->benchmark, cfg->memsize, total_time, cfg->corelist_size, total_ops, thpt,
+               plat_time_to_ms(vmops_hist_mean(hist)), hist);
+
+    free(hist);
+
+    if (jsonout != NULL) {
+        vmops_report_json(args);
+    }
+}
+
+
+/*
+ * ================================================================================================
+ * Address Space Population
+ * ================================================================================================
+ */
+
+
+///< the mappings that populate the address space while a benchmark runs
+static struct utils_population
+{
+    plat_memobj_t memobj;  ///< the page all mappings of the population map
+    size_t n;              ///< the number of mappings
+    size_t step;           ///< the distance between two mappings
+} utils_population;
+
+
+/**
+ * @brief removes the mappings that populate the address space
+ */
+static void utils_population_destroy(void)
+{
+    struct utils_population *pop = &utils_population;
+
+    for (size_t i = 0; i < pop->n; i++) {
+        plat_vm_unmap((void *)(POPULATION_ADDRESS + i * pop->step), PLAT_ARCH_BASE_PAGE_SIZE);
+    }
+
+    if (pop->memobj != NULL) {
+        plat_vm_destroy(pop->memobj);
+    }
+
+    memset(pop, 0, sizeof(*pop));
+}
+
+
+/**
+ * @brief populates the address space with unrelated mappings
+ *
+ * @param cfg   the benchmark configuration
+ *
+ * @returns 0 on success, -1 on failure
+ *
+ * The mappings are spread evenly over their region of the address space and are separated by
+ * unmapped pages, so none of them can be merged. They map a single page without populating
+ * it, such that they only cost their entry in the address space.
+ */
+static int utils_population_create(struct vmops_bench_cfg *cfg)
+{
+    plat_error_t err;
+    struct utils_population *pop = &utils_population;
+
+    size_t n = cfg->population;
+    if (n > POPULATION_REGION_SIZE / (2 * PLAT_ARCH_BASE_PAGE_SIZE)) {
+        LOG_ERR("the population of %zu mappings does not fit into its region\n", n);
+        return -1;
+    }
+
+    if (n > 0) {
+        err = plat_vm_create(VMOBJ_NAME_POPULATION, &pop->memobj, PLAT_ARCH_BASE_PAGE_SIZE,
+                             PLAT_PAGE_BASE, PLAT_MEMOBJ_MEMFD);
+        if (err != PLAT_ERR_OK) {
+            LOG_ERR("could not create the memory object of the population\n");
+            return -1;
+        }
+
+        pop->step = (POPULATION_REGION_SIZE / n) & ~(PLAT_ARCH_BASE_PAGE_SIZE - 1UL);
+        LOG_INFO("populating the address space with %zu mappings, %zu kB apart\n", n,
+                 pop->step >> 10);
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        void *addr = (void *)(POPULATION_ADDRESS + i * pop->step);
+        err = plat_vm_map_lazy(&addr, PLAT_ARCH_BASE_PAGE_SIZE, pop->memobj, 0, PLAT_PAGE_BASE);
+        if (err == PLAT_ERR_NOT_SUPPORTED) {
+            err = plat_vm_map_fixed(addr, PLAT_ARCH_BASE_PAGE_SIZE, pop->memobj, 0,
+                                    PLAT_PAGE_BASE);
+        }
+
+        if (err != PLAT_ERR_OK) {
+            LOG_ERR("could not create mapping %zu of the population. vm.max_map_count?\n", i);
+            utils_population_destroy();
+            return -1;
+        }
+        pop->n++;
+    }
+
+    cfg->vmas = 0;
+    if (plat_vm_count_mappings(&cfg->vmas) == PLAT_ERR_OK) {
+        LOG_INFO("the address space holds %zu mappings\n", cfg->vmas);
+    }
+
+    return 0;
 }
 
 
@@ -173,6 +530,39 @@ void vmops_utils_print_csv(struct vmops_bench_run_arg *args)
  */
 
 
+/**
+ * @brief allocates zeroed memory that is shared with the benchmark processes
+ *
+ * @param size  the size of the allocation
+ *
+ * @returns the allocated memory, NULL on failure
+ */
+static void *utils_shared_alloc(size_t size)
+{
+    void *mem;
+    if (plat_mem_alloc(size, &mem) != PLAT_ERR_OK) {
+        return NULL;
+    }
+    return mem;
+}
+
+
+/**
+ * @brief frees memory allocated with utils_shared_alloc
+ *
+ * @param mem   the allocated memory, may be NULL
+ * @param size  the size of the allocation
+ */
+static void utils_shared_free(void *mem, size_t size)
+{
+    plat_mem_free(mem, size);
+}
+
+
+///< the size of the repetition state, followed by the throughput of each repetition
+#define utils_reps_size(_max) (sizeof(struct vmops_reps) + (_max) * sizeof(double))
+
+
 /**
  * @brief prepares the arguments for teh benchmark threads
  *
@@ -186,33 +576,54 @@ int vmops_utils_prepare_args(struct vmops_bench_cfg *cfg, void *shared,
 {
     plat_error_t err;
 
-    /* create the threads */
-    struct vmops_bench_run_arg *args = calloc(cfg->corelist_size + 1,
-                                              sizeof(struct vmops_bench_run_arg));
-    if (args == NULL) {
+    /* the arguments are placed on the node of their thread and first touched by it */
+    struct vmops_bench_run_arg *args;
+    size_t argsize = (cfg->corelist_size + 1) * sizeof(struct vmops_bench_run_arg);
+    if (plat_mem_alloc(argsize, (void **)&args) != PLAT_ERR_OK) {
         return -1;
     }
 
-    struct statval *vals = NULL;
+    for (uint32_t i = 0; i < cfg->corelist_size; i++) {
+        plat_mem_bind_local(&args[i], sizeof(struct vmops_bench_run_arg), cfg->coreslist[i]);
+    }
+
     if (cfg->stats) {
-        LOG_INFO("allocating stats. %zu kB memory\n",
-                 (cfg->corelist_size * cfg->stats * sizeof(struct statval)) >> 10);
-        vals = calloc(cfg->corelist_size, cfg->stats * sizeof(struct statval));
-        if (vals == NULL) {
-            LOG_WARN("disabling statistics. failed to get memory!\n");
-            cfg->stats = 0;
+        size_t valsize = cfg->stats * sizeof(struct statval);
+        LOG_INFO("allocating stats. %zu kB memory\n", (cfg->corelist_size * valsize) >> 10);
+        for (uint32_t i = 0; i < cfg->corelist_size; i++) {
+            if (plat_mem_alloc(valsize, (void **)&args[i].stats.values) != PLAT_ERR_OK) {
+                LOG_WARN("disabling statistics. failed to get memory!\n");
+                for (uint32_t j = 0; j < i; j++) {
+                    plat_mem_free(args[j].stats.values, valsize);
+                    args[j].stats.values = NULL;
+                }
+                cfg->stats = 0;
+                break;
+            }
+            plat_mem_bind_local(args[i].stats.values, valsize, cfg->coreslist[i]);
         }
     }
 
     size_t totalmem = cfg->shared ? cfg->memsize : cfg->corelist_size * cfg->memsize;
     size_t totalmemobjs = cfg->shared ? 1 : cfg->corelist_size;
 
-    LOG_INFO("creating %zu memory objects of size %zu\n", totalmemobjs, cfg->memsize);
+    LOG_INFO("creating %zu %s memory objects of size %zu\n", totalmemobjs,
+             utils_memobj_types[cfg->memobj], cfg->memsize);
     LOG_INFO("total memory usage = %zu kB\n", totalmem >> 10);
 
+    /* files are created in the given directory, the other memory objects only have a name */
+    const char *dir = "";
+    if (cfg->memobj == PLAT_MEMOBJ_FILE || cfg->memobj == PLAT_MEMOBJ_FILE_PREALLOC) {
+        dir = cfg->memobj_dir;
+        LOG_INFO("creating the files in '%s'\n", dir);
+    }
+
+    static char pathbuf[256];
+
     if (cfg->shared) {
         plat_memobj_t memobj;
-        err = plat_vm_create(VMOBJ_NAME_SHARED, &memobj, cfg->memsize, cfg->maphuge);
+        snprintf(pathbuf, sizeof(pathbuf), "%s" VMOBJ_NAME_SHARED, dir);
+        err = plat_vm_create(pathbuf, &memobj, cfg->memsize, cfg->pages, cfg->memobj);
         if (err != PLAT_ERR_OK) {
             LOG_ERR("creation of shared memory object failed!\n");
             goto err_out;
@@ -221,16 +632,15 @@ int vmops_utils_prepare_args(struct vmops_bench_cfg *cfg, void *shared,
             args[i].memobj = memobj;
         }
     } else {
-        static char pathbuf[256];
-
         for (uint32_t i = 0; i < cfg->corelist_size; i++) {
-            snprintf(pathbuf, sizeof(pathbuf), VMOBJ_NAME_INDEPENDENT, cfg->coreslist[i]);
-            err = plat_vm_create(pathbuf, &args[i].memobj, cfg->memsize, cfg->maphuge);
+            snprintf(pathbuf, sizeof(pathbuf), "%s" VMOBJ_NAME_INDEPENDENT, dir, i);
+            err = plat_vm_create(pathbuf, &args[i].memobj, cfg->memsize, cfg->pages,
+                                 cfg->memobj);
             if (err != PLAT_ERR_OK) {
                 LOG_ERR("creation of shared memory object failed! [%d / %d]\n", i,
                         cfg->corelist_size);
                 for (uint32_t j = 0; j < i; j++) {
-                    plat_vm_destroy(args[i].memobj);
+                    plat_vm_destroy(args[j].memobj);
                 }
                 goto err_out;
             }
@@ -238,26 +648,55 @@ int vmops_utils_prepare_args(struct vmops_bench_cfg *cfg, void *shared,
     }
 
 
-    /* */
-    for (size_t i = 0; i < BENCHMARK_PREPOPULATE_MAPPINGS; i++) {
-        void *addr;
-        err = plat_vm_map(&addr, PLAT_ARCH_BASE_PAGE_SIZE, args[0].memobj, 0, 0);
-        if (err != PLAT_ERR_OK) {
-            LOG_ERR("could not prepopulate with %d mappings\n", BENCHMARK_PREPOPULATE_MAPPINGS);
-            goto err_out;
+    /* the kernel may back the mappings with other pages than the requested ones */
+    void *probe;
+    size_t pagesize = plat_page_size(cfg->pages);
+    err = plat_vm_map(&probe, pagesize, args[0].memobj, 0, cfg->pages);
+    if (err != PLAT_ERR_OK) {
+        LOG_ERR("could not map a page of %zu kB. are huge pages reserved?\n", pagesize >> 10);
+        goto err_out_memobj;
+    }
+
+    cfg->page_size = 0;
+    if (plat_vm_page_size(probe, &cfg->page_size) == PLAT_ERR_OK) {
+        LOG_INFO("the mappings are backed by pages of %zu kB\n", cfg->page_size >> 10);
+        if (cfg->page_size < pagesize) {
+            LOG_WARN("requested pages of %zu kB, the kernel used smaller ones\n",
+                     pagesize >> 10);
         }
     }
 
+    plat_vm_unmap(probe, pagesize);
+
+    if (utils_population_create(cfg)) {
+        goto err_out_memobj;
+    }
+
     for (uint32_t i = 0; i < cfg->corelist_size; i++) {
         args[i].tid = i;
         args[i].cfg = cfg;
         args[i].shared = shared;
         args[i].coreid = cfg->coreslist[i];
         args[i].stats.sampling_delta = plat_convert_time(cfg->rate);
-        args[i].stats.sampling_next = 0;
         args[i].stats.idx_max = cfg->stats;
-        args[i].stats.dryrun = 10;
-        args[i].stats.values = cfg->stats > 0 ? vals + cfg->stats * i : NULL;
+        args[i].stats.warmup = false;
+        args[i].stats.progress = &args[i].progress;
+        args[i].stats.pacing_delta = cfg->oprate ? plat_convert_time(1000) / cfg->oprate : 0;
+        args[i].stats.pacing_next = 0;
+        for (uint32_t op = 0; op < VMOPS_OP_MAX; op++) {
+            args[i].stats.sampling_next[op] = 0;
+        }
+    }
+
+    if (cfg->tracefile != NULL) {
+        args->trace = vmops_trace_open(cfg->tracefile, cfg);
+        if (args->trace == NULL) {
+            LOG_ERR("could not create the latency trace\n");
+            goto err_out_memobj;
+        }
+        for (uint32_t i = 0; i < cfg->corelist_size; i++) {
+            args[i].stats.ring = vmops_trace_ring(args->trace, i);
+        }
     }
 
     args[cfg->corelist_size].tid = -1;
@@ -266,8 +705,21 @@ int vmops_utils_prepare_args(struct vmops_bench_cfg *cfg, void *shared,
 
     return 0;
 
+err_out_memobj:
+    if (cfg->shared) {
+        plat_vm_destroy(args[0].memobj);
+    } else {
+        for (uint32_t i = 0; i < cfg->corelist_size; i++) {
+            plat_vm_destroy(args[i].memobj);
+        }
+    }
+
 err_out:
-    free(args);
+    utils_population_destroy();
+    for (uint32_t i = 0; i < cfg->corelist_size; i++) {
+        plat_mem_free(args[i].stats.values, cfg->stats * sizeof(struct statval));
+    }
+    plat_mem_free(args, argsize);
     return -1;
 }
 
@@ -297,6 +749,8 @@ int vmops_utils_cleanup_args(struct vmops_bench_run_arg *args)
             memobj = current->memobj;
         }
 
+        plat_mem_free(current->stats.values, cfg->stats * sizeof(struct statval));
+
         if (current->cfg != cfg) {
             LOG_ERR("invalid thread arguments structure!\n");
         }
@@ -304,9 +758,16 @@ int vmops_utils_cleanup_args(struct vmops_bench_run_arg *args)
         current++;
     }
 
+    utils_population_destroy();
+
     LOG_INFO("cleanup done.\n");
 
-    free(args);
+    vmops_trace_close(args->trace);
+    if (args->reps != NULL) {
+        utils_shared_free(args->reps, utils_reps_size(args->reps->max));
+    }
+    utils_shared_free(args->irqcounts, 3 * sizeof(struct plat_irqcounts));
+    plat_mem_free(args, (cfg->corelist_size + 1) * sizeof(struct vmops_bench_run_arg));
 
     return 0;
 }
@@ -314,54 +775,799 @@ int vmops_utils_cleanup_args(struct vmops_bench_run_arg *args)
 
 /*
  * ================================================================================================
- * Benchmark Running
+ * Time Series Sampler
  * ================================================================================================
  */
 
 
+struct utils_sampler
+{
+    struct vmops_bench_run_arg arg;    ///< the arguments of the sampler thread
+    struct vmops_bench_run_arg *args;  ///< the arguments of the benchmark threads
+    uint32_t nthreads;                 ///< the number of benchmark threads
+    volatile bool done;                ///< set when the benchmark threads have exited
+};
+
+
 /**
- * @brief generic run function for the benchmark threads
+ * @brief periodically prints the progress of the benchmark threads
  *
- * @param nthreads  number of arguments
- * @param args      the arguments for the threads
- * @param runfn     the function to be run
+ * @param arg   the arguments of the sampler thread
  *
- * @returns 0 on success, -1 on failure
+ * @returns NULL
  */
-int vmops_utils_run_benchmark(uint32_t nthreads, struct vmops_bench_run_arg *args,
-                              plat_thread_fn_t runfn)
+static void *utils_sampler_run_fn(struct vmops_bench_run_arg *arg)
 {
-    plat_error_t err;
-
-    /* initialize barrier */
-    plat_barrier_t barrier;
-    err = plat_thread_barrier_init(&barrier, nthreads);
-    if (err != PLAT_ERR_OK) {
-        LOG_ERR("failed to initialize barrier\n");
-        return -1;
+    struct utils_sampler *sampler = (struct utils_sampler *)arg->shared;
+    struct vmops_bench_cfg *cfg = arg->cfg;
+    uint32_t nthreads = sampler->nthreads;
+
+    uint64_t *prev_ops = calloc(nthreads, sizeof(uint64_t));
+    struct vmops_hist *prev_hist = malloc((nthreads + 3) * sizeof(struct vmops_hist));
+    if (prev_ops == NULL || prev_hist == NULL) {
+        LOG_ERR("sampler could not allocate memory. exiting.\n");
+        free(prev_ops);
+        free(prev_hist);
+        return NULL;
     }
 
-    LOG_INFO("creating %d threads\n", nthreads);
+    /* scratch histograms for the current snapshot, the interval, and the aggregate */
+    struct vmops_hist *cur = &prev_hist[nthreads];
+    struct vmops_hist *interval = &prev_hist[nthreads + 1];
+    struct vmops_hist *total = &prev_hist[nthreads + 2];
+
     for (uint32_t i = 0; i < nthreads; i++) {
-        LOG_INFO("thread %d on core %d\n", args[i].tid, args[i].coreid);
-        args[i].barrier = barrier;
-        args[i].thread = plat_thread_start(runfn, &args[i], args[i].coreid);
-        if (args[i].thread == NULL) {
-            LOG_ERR("failed to start threads! [%d / %d]\n", i, nthreads);
-            for (uint32_t j = 0; j < i; j++) {
-                plat_thread_cancel(args[j].thread);
-            }
-            return -1;
-        }
+        vmops_hist_reset(&prev_hist[i]);
     }
 
-    for (uint32_t i = 0; i < nthreads; i++) {
-        if (args[i].thread != NULL) {
-            plat_thread_join(args[i].thread);
+    plat_time_t t_delta = plat_convert_time(cfg->sampler_ms);
+    plat_time_t t_start = plat_get_time();
+    plat_time_t t_last = t_start;
+    plat_time_t t_next = t_start + t_delta;
+
+    LOG_TS_HEADER();
+
+    /* the values are read while the threads update them, a sample may be off by a few ops */
+    bool done;
+    do {
+        while (!(done = sampler->done) && plat_get_time() < t_next) {
+            plat_usleep(100);
         }
-    }
 
-    plat_thread_barrier_destroy(barrier);
+        plat_time_t t_now = plat_get_time();
+        double elapsed = plat_time_to_ms(t_now - t_start);
+        double delta = plat_time_to_ms(t_now - t_last);
 
-    return 0;
+        uint64_t total_ops = 0;
+        vmops_hist_reset(total);
+
+        for (uint32_t i = 0; i < nthreads; i++) {
+            struct vmops_stats *stats = &sampler->args[i].stats;
+
+            uint64_t ops = __atomic_load_n(&stats->progress->ops, __ATOMIC_RELAXED);
+            uint64_t ops_delta = ops >= prev_ops[i] ? ops - prev_ops[i] : ops;
+            prev_ops[i] = ops;
+
+            vmops_hist_reset(cur);
+            for (uint32_t op = 0; op < VMOPS_OP_MAX; op++) {
+                vmops_hist_merge(cur, &stats->hist[op]);
+            }
+
+            /* the histograms only grow, unless the thread has reset them in the meantime */
+            memcpy(interval, cur, sizeof(*interval));
+            if (cur->count >= prev_hist[i].count) {
+                vmops_hist_sub(interval, &prev_hist[i]);
+            }
+            memcpy(&prev_hist[i], cur, sizeof(*cur));
+
+            LOG_TS(cfg, elapsed, (int)i, ops_delta, delta, interval);
+
+            total_ops += ops_delta;
+            vmops_hist_merge(total, interval);
+        }
+
+        LOG_TS(cfg, elapsed, -1, total_ops, delta, total);
+
+        t_last = t_now;
+        t_next += t_delta;
+    } while (!done);
+
+    free(prev_ops);
+    free(prev_hist);
+
+    return NULL;
+}
+
+
+/**
+ * @brief selects a core for a helper thread that does not run a benchmark thread
+ *
+ * @param cfg   the benchmark configuration
+ *
+ * @returns the core id for the sampler thread
+ */
+static uint32_t utils_idle_core(struct vmops_bench_cfg *cfg)
+{
+    uint32_t *cores;
+    uint32_t ncores;
+
+    if (plat_get_topology(PLAT_TOPOLOGY_NUMA_FILL, PLAT_TOPOLOGY_CORES_FILL, &cores, &ncores)
+        == PLAT_ERR_OK) {
+        for (uint32_t i = 0; i < ncores; i++) {
+            bool used = false;
+            for (uint32_t j = 0; j < cfg->corelist_size; j++) {
+                used = used || (cores[i] == cfg->coreslist[j]);
+            }
+
+            if (!used) {
+                uint32_t core = cores[i];
+                free(cores);
+                return core;
+            }
+        }
+        free(cores);
+    }
+
+    LOG_WARN("no idle core for the helper threads. sharing core %d with thread 0\n",
+             cfg->coreslist[0]);
+
+    return cfg->coreslist[0];
+}
+
+
+/**
+ * @brief starts the sampler thread
+ *
+ * @param nthreads  the number of benchmark threads
+ * @param args      the arguments of the benchmark threads
+ *
+ * @returns the sampler state, NULL on failure
+ */
+static struct utils_sampler *utils_sampler_start(uint32_t nthreads,
+                                                 struct vmops_bench_run_arg *args)
+{
+    struct utils_sampler *sampler = aligned_alloc(_Alignof(struct utils_sampler),
+                                                  sizeof(struct utils_sampler));
+    if (sampler == NULL) {
+        return NULL;
+    }
+    memset(sampler, 0, sizeof(struct utils_sampler));
+
+    sampler->args = args;
+    sampler->nthreads = nthreads;
+    sampler->done = false;
+    sampler->arg.cfg = args->cfg;
+    sampler->arg.tid = nthreads;
+    sampler->arg.coreid = utils_idle_core(args->cfg);
+    sampler->arg.shared = sampler;
+
+    LOG_INFO("sampler thread on core %d, interval %d ms\n", sampler->arg.coreid,
+             args->cfg->sampler_ms);
+
+    sampler->arg.thread = plat_thread_start(utils_sampler_run_fn, &sampler->arg,
+                                            sampler->arg.coreid);
+    if (sampler->arg.thread == NULL) {
+        free(sampler);
+        return NULL;
+    }
+
+    return sampler;
+}
+
+
+/**
+ * @brief stops the sampler thread after it has taken the final sample
+ *
+ * @param sampler   the sampler state
+ */
+static void utils_sampler_stop(struct utils_sampler *sampler)
+{
+    sampler->done = true;
+    plat_thread_join(sampler->arg.thread);
+    free(sampler);
+}
+
+
+/*
+ * ================================================================================================
+ * Repetitions
+ * ================================================================================================
+ */
+
+
+///< two-sided 95% quantiles of the t-distribution, indexed by the degrees of freedom minus one
+static const double utils_reps_t95[] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201,  2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080,  2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042,
+};
+
+
+/**
+ * @brief calculates the summary statistics of the completed repetitions
+ *
+ * @param reps      the repetition state
+ * @param mean      returns the mean throughput
+ * @param stddev    returns the sample standard deviation of the throughput
+ * @param ci        returns the half width of the 95% confidence interval of the mean
+ */
+static void utils_reps_summary(struct vmops_reps *reps, double *mean, double *stddev, double *ci)
+{
+    *mean = 0;
+    *stddev = 0;
+    *ci = 0;
+
+    if (reps->n == 0) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < reps->n; i++) {
+        *mean += reps->thpt[i];
+    }
+    *mean /= reps->n;
+
+    if (reps->n == 1) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < reps->n; i++) {
+        *stddev += (reps->thpt[i] - *mean) * (reps->thpt[i] - *mean);
+    }
+    *stddev = sqrt(*stddev / (reps->n - 1));
+
+    uint32_t df = reps->n - 1;
+    double t = df <= sizeof(utils_reps_t95) / sizeof(utils_reps_t95[0]) ? utils_reps_t95[df - 1]
+                                                                        : 1.960;
+    *ci = t * *stddev / sqrt(reps->n);
+}
+
+
+/**
+ * @brief records the throughput of the completed repetition and decides whether to stop
+ *
+ * @param args  the arguments of the first thread
+ */
+static void utils_reps_record(struct vmops_bench_run_arg *args)
+{
+    struct vmops_reps *reps = args->reps;
+    struct vmops_bench_cfg *cfg = args->cfg;
+
+    double thpt = 0;
+    for (struct vmops_bench_run_arg *a = args; a->tid != (uint32_t)-1; a++) {
+        if (a->background) {
+            continue;
+        }
+
+        if (a->duration == 0) {
+            LOG_ERR("thread %u failed in repetition %u\n", a->tid, reps->n + 1);
+            reps->failed = true;
+            reps->done = true;
+            return;
+        }
+
+        thpt += (double)a->count * 1000.0 / a->duration;
+    }
+
+    reps->thpt[reps->n++] = thpt;
+
+    LOG_RESULT_REP(cfg->benchmark, reps->n, thpt);
+
+    if (reps->n == reps->max) {
+        reps->done = true;
+        return;
+    }
+
+    if (cfg->reps_ci > 0 && reps->n >= VMOPS_REPS_MIN) {
+        double mean, stddev, ci;
+        utils_reps_summary(reps, &mean, &stddev, &ci);
+        reps->done = mean > 0 && ci * 100.0 / mean <= cfg->reps_ci;
+    }
+}
+
+
+/**
+ * @brief prints the summary of all repetitions
+ *
+ * @param cfg   the benchmark configuration
+ * @param reps  the repetition state
+ */
+static void utils_reps_print(struct vmops_bench_cfg *cfg, struct vmops_reps *reps)
+{
+    if (reps->n == 0) {
+        return;
+    }
+
+    double mean, stddev, ci;
+    utils_reps_summary(reps, &mean, &stddev, &ci);
+
+    double min = reps->thpt[0];
+    double max = reps->thpt[0];
+    for (uint32_t i = 1; i < reps->n; i++) {
+        min = reps->thpt[i] < min ? reps->thpt[i] : min;
+        max = reps->thpt[i] > max ? reps->thpt[i] : max;
+    }
+
+    if (cfg->reps_ci > 0 && mean > 0 && ci * 100.0 / mean > cfg->reps_ci) {
+        LOG_WARN("confidence interval not within %.2f%% after %u repetitions\n", cfg->reps_ci,
+                 reps->n);
+    }
+
+    LOG_RESULT_REPS(cfg->benchmark, reps->n, mean, stddev, ci, min, max);
+}
+
+
+/*
+ * ================================================================================================
+ * Benchmark Running
+ * ================================================================================================
+ */
+
+
+/**
+ * @brief initializes the state of a benchmark thread from the thread itself
+ *
+ * @param args  the arguments of the benchmark thread
+ *
+ * Writing the histograms and the sample buffer from the pinned thread backs them with pages of
+ * the thread's local NUMA node, also where the platform cannot bind memory to a node.
+ */
+static void utils_thread_first_touch(struct vmops_bench_run_arg *args)
+{
+    for (uint32_t op = 0; op < VMOPS_OP_MAX; op++) {
+        vmops_hist_reset(&args->stats.hist[op]);
+    }
+
+    if (args->stats.values != NULL) {
+        memset(args->stats.values, 0, args->stats.idx_max * sizeof(struct statval));
+    }
+}
+
+
+static void *utils_thread_run_fn(struct vmops_bench_run_arg *args)
+{
+    utils_thread_first_touch(args);
+
+    args->t_wake = 0;
+    args->t_late = 0;
+
+    if (args->cfg->perfctr) {
+        if (plat_perfctr_open(&args->perfctr) != PLAT_ERR_OK) {
+            LOG_WARN("thread %d. could not open the performance counters\n", args->tid);
+            args->perfctr = NULL;
+        }
+    }
+
+    memset(args->perfctr_delta, 0, sizeof(args->perfctr_delta));
+
+    size_t count = 0;
+    double duration = 0;
+
+    void *ret;
+    for (;;) {
+        /* the run function sets them only if the thread completed the repetition */
+        args->count = 0;
+        args->duration = 0;
+
+        ret = args->runfn(args);
+
+        count += args->count;
+        duration += args->duration;
+
+        if (args->reps == NULL) {
+            break;
+        }
+
+        /* all threads have finished the repetition before the first one evaluates it */
+        plat_thread_barrier(args->barrier);
+        if (args->tid == 0) {
+            utils_reps_record(args);
+        }
+        plat_thread_barrier(args->barrier);
+
+        if (args->reps->done) {
+            break;
+        }
+
+        args->stats.pacing_next = 0;
+        for (uint32_t op = 0; op < VMOPS_OP_MAX; op++) {
+            args->stats.sampling_next[op] = 0;
+        }
+    }
+
+    /* the results of all repetitions are reported together */
+    args->count = count;
+    args->duration = duration;
+
+    if (args->perfctr != NULL) {
+        plat_perfctr_close(args->perfctr);
+        args->perfctr = NULL;
+    }
+
+    return ret;
+}
+
+
+/**
+ * @brief generic run function for the benchmark threads
+ *
+ * @param nthreads  number of arguments
+ * @param args      the arguments for the threads
+ * @param runfn     the function to be run
+ *
+ * @returns 0 on success, -1 on failure
+ */
+int vmops_utils_run_benchmark(uint32_t nthreads, struct vmops_bench_run_arg *args,
+                              plat_thread_fn_t runfn)
+{
+    plat_error_t err;
+
+    /* initialize barrier */
+    plat_barrier_t barrier;
+    err = plat_thread_barrier_init(&barrier, nthreads);
+    if (err != PLAT_ERR_OK) {
+        LOG_ERR("failed to initialize barrier\n");
+        return -1;
+    }
+
+    /* the state of all threads is shared with the benchmark processes */
+    struct vmops_warmup *warmup = NULL;
+    if (args->cfg->warmup_ms || args->cfg->steady_cv > 0) {
+        warmup = utils_shared_alloc(sizeof(struct vmops_warmup));
+        if (warmup == NULL) {
+            LOG_ERR("failed to allocate the warmup state\n");
+            plat_thread_barrier_destroy(barrier);
+            return -1;
+        }
+    }
+
+    for (uint32_t i = 0; i < nthreads; i++) {
+        args[i].warmup = warmup;
+        args[i].stats.warmup = (warmup != NULL);
+    }
+
+    /* the threads and memory objects are reused for all repetitions */
+    struct vmops_reps *reps = NULL;
+    if (args->cfg->reps > 1 || args->cfg->reps_ci > 0) {
+        uint32_t max = args->cfg->reps > 1 ? args->cfg->reps : VMOPS_REPS_MAX;
+        reps = utils_shared_alloc(utils_reps_size(max));
+        if (reps == NULL) {
+            LOG_ERR("failed to allocate the repetition state\n");
+            utils_shared_free(warmup, sizeof(struct vmops_warmup));
+            plat_thread_barrier_destroy(barrier);
+            return -1;
+        }
+        reps->max = max;
+        reps->thpt = (double *)(reps + 1);
+    }
+
+    for (uint32_t i = 0; i < nthreads; i++) {
+        args[i].reps = reps;
+    }
+
+    if (args->trace != NULL) {
+        if (vmops_trace_start(args->trace, utils_idle_core(args->cfg))) {
+            if (reps != NULL) {
+                utils_shared_free(reps, utils_reps_size(reps->max));
+            }
+            utils_shared_free(warmup, sizeof(struct vmops_warmup));
+            plat_thread_barrier_destroy(barrier);
+            return -1;
+        }
+    }
+
+    struct utils_sampler *sampler = NULL;
+    if (args->cfg->sampler_ms) {
+        sampler = utils_sampler_start(nthreads, args);
+        if (sampler == NULL) {
+            LOG_WARN("could not start the sampler thread. continuing without.\n");
+        }
+    }
+
+    /* the interrupts are accounted system wide by the first thread */
+    args->irqstats = NULL;
+    if (plat_irqstats_open(&args->irqstats) == PLAT_ERR_OK) {
+        if (args->irqcounts == NULL) {
+            args->irqcounts = utils_shared_alloc(3 * sizeof(struct plat_irqcounts));
+        }
+        if (args->irqcounts != NULL) {
+            memset(&args->irqcounts[1], 0, sizeof(struct plat_irqcounts));
+        }
+        if (args->irqcounts == NULL) {
+            LOG_WARN("could not allocate the interrupt counts\n");
+            plat_irqstats_close(args->irqstats);
+            args->irqstats = NULL;
+        }
+    } else {
+        LOG_WARN("interrupt accounting not available\n");
+        args->irqstats = NULL;
+        utils_shared_free(args->irqcounts, 3 * sizeof(struct plat_irqcounts));
+        args->irqcounts = NULL;
+    }
+
+    bool processes = args->cfg->processes;
+    LOG_INFO("creating %d %s\n", nthreads, processes ? "processes" : "threads");
+    for (uint32_t i = 0; i < nthreads; i++) {
+        LOG_INFO("thread %d on core %d\n", args[i].tid, args[i].coreid);
+        args[i].barrier = barrier;
+        args[i].runfn = runfn;
+        if (processes) {
+            args[i].thread = plat_process_start(utils_thread_run_fn, &args[i], args[i].coreid);
+        } else {
+            args[i].thread = plat_thread_start(utils_thread_run_fn, &args[i], args[i].coreid);
+        }
+        if (args[i].thread == NULL) {
+            LOG_ERR("failed to start threads! [%d / %d]\n", i, nthreads);
+            for (uint32_t j = 0; j < i; j++) {
+                plat_thread_cancel(args[j].thread);
+            }
+            if (sampler != NULL) {
+                utils_sampler_stop(sampler);
+            }
+            return -1;
+        }
+    }
+
+    for (uint32_t i = 0; i < nthreads; i++) {
+        if (args[i].thread != NULL) {
+            plat_thread_join(args[i].thread);
+        }
+    }
+
+    if (sampler != NULL) {
+        utils_sampler_stop(sampler);
+    }
+
+    if (args->trace != NULL) {
+        vmops_trace_stop(args->trace);
+    }
+
+    if (args->irqstats != NULL) {
+        plat_irqstats_close(args->irqstats);
+        args->irqstats = NULL;
+    }
+
+    plat_thread_barrier_destroy(barrier);
+
+    bool failed = reps != NULL && reps->failed;
+    if (failed) {
+        LOG_ERR("discarding the repetitions, a thread failed\n");
+    } else if (reps != NULL) {
+        utils_reps_print(args->cfg, reps);
+    }
+
+    /* the first thread keeps the repetitions for the result record, freed on cleanup */
+    utils_shared_free(warmup, sizeof(struct vmops_warmup));
+    for (uint32_t i = 0; i < nthreads; i++) {
+        args[i].warmup = NULL;
+        args[i].reps = i == 0 ? reps : NULL;
+    }
+
+    return failed ? -1 : 0;
+}
+
+
+/**
+ * @brief starts the measured window of a benchmark thread
+ *
+ * @param args  the arguments of the thread
+ *
+ * @returns the start time of the measured window, common to all threads
+ */
+plat_time_t vmops_utils_window_begin(struct vmops_bench_run_arg *args)
+{
+    struct vmops_window *window = &(args - args->tid)->window;
+
+    if (args->irqstats != NULL) {
+        if (plat_irqstats_read(args->irqstats, &args->irqcounts[0]) != PLAT_ERR_OK) {
+            LOG_WARN("could not read the interrupt counts\n");
+        }
+    }
+
+    plat_thread_barrier(args->barrier);
+
+    /* the start is set once all threads have arrived, and gives them time to wake up */
+    if (args->tid == 0) {
+        window->t_released = plat_get_time();
+        window->t_start = window->t_released + plat_convert_time(VMOPS_WINDOW_START_DELAY_MS);
+
+        if (args->warmup != NULL) {
+            struct vmops_bench_cfg *cfg = args->cfg;
+            uint32_t warmup_ms = cfg->warmup_ms ? cfg->warmup_ms : VMOPS_WARMUP_MAX_MS;
+            args->warmup->t_last = window->t_start;
+            args->warmup->t_deadline = window->t_start + plat_convert_time(warmup_ms);
+        }
+    }
+
+    plat_thread_barrier(args->barrier);
+
+    plat_time_t t_wake = plat_get_time();
+    while (plat_get_time() < window->t_start) {
+        /* spin until the common start */
+    }
+
+    /* the threads that only woke up after the start are late */
+    plat_time_t t_late = t_wake > window->t_start ? t_wake - window->t_start : 0;
+    t_wake -= window->t_released;
+    args->t_wake = t_wake > args->t_wake ? t_wake : args->t_wake;
+    args->t_late = t_late > args->t_late ? t_late : args->t_late;
+
+    if (args->perfctr != NULL) {
+        plat_perfctr_read(args->perfctr, args->perfctr_start);
+    }
+
+    /* all threads share the start, and with it the deadline of the measured window */
+    return window->t_start;
+}
+
+
+/**
+ * @brief ends the measured window of a benchmark thread
+ *
+ * @param args  the arguments of the thread
+ */
+void vmops_utils_window_end(struct vmops_bench_run_arg *args)
+{
+    if (args->perfctr != NULL) {
+        uint64_t values[PLAT_PERFCTR_MAX];
+        if (plat_perfctr_read(args->perfctr, values) == PLAT_ERR_OK) {
+            for (uint32_t i = 0; i < PLAT_PERFCTR_MAX; i++) {
+                args->perfctr_delta[i] += values[i] - args->perfctr_start[i];
+            }
+        }
+    }
+
+    plat_thread_barrier(args->barrier);
+
+    /* the other threads wait until the interrupts of the window have been read */
+    if (args->irqstats != NULL) {
+        struct plat_irqcounts *now = &args->irqcounts[2];
+        if (plat_irqstats_read(args->irqstats, now) == PLAT_ERR_OK) {
+            const struct plat_irqcounts *start = &args->irqcounts[0];
+            struct plat_irqcounts *delta = &args->irqcounts[1];
+            for (uint32_t i = 0; i < PLAT_IRQSTATS_MAX_CORES; i++) {
+                for (uint32_t j = 0; j < PLAT_IPI_MAX; j++) {
+                    delta->ipis[i][j] += now->ipis[i][j] - start->ipis[i][j];
+                }
+            }
+            for (uint32_t i = 0; i < PLAT_TLBFLUSH_MAX; i++) {
+                delta->tlbflush[i] += now->tlbflush[i] - start->tlbflush[i];
+            }
+            delta->has_tlbflush = now->has_tlbflush;
+        }
+    }
+
+    plat_thread_barrier(args->barrier);
+}
+
+
+/*
+ * ================================================================================================
+ * Warmup
+ * ================================================================================================
+ */
+
+
+/**
+ * @brief takes a throughput sample of all threads and checks for the steady state
+ *
+ * @param args      the arguments of the first thread
+ * @param t_current the current time
+ *
+ * @returns true if the throughput has become stable, false otherwise
+ */
+static bool utils_warmup_steady(struct vmops_bench_run_arg *args, plat_time_t t_current)
+{
+    struct vmops_warmup *warmup = args->warmup;
+
+    if (t_current - warmup->t_last < plat_convert_time(VMOPS_WARMUP_INTERVAL_MS)) {
+        return false;
+    }
+
+    uint64_t ops = 0;
+    for (struct vmops_bench_run_arg *a = args; a->tid != (uint32_t)-1; a++) {
+        ops += __atomic_load_n(&a->stats.progress->ops, __ATOMIC_RELAXED);
+    }
+
+    double thpt = (double)(ops - warmup->ops) / plat_time_to_ms(t_current - warmup->t_last);
+    warmup->thpt[warmup->nsamples % VMOPS_WARMUP_WINDOW] = thpt;
+    warmup->nsamples++;
+    warmup->ops = ops;
+    warmup->t_last = t_current;
+
+    if (warmup->nsamples < VMOPS_WARMUP_WINDOW) {
+        return false;
+    }
+
+    double mean = 0;
+    for (uint32_t i = 0; i < VMOPS_WARMUP_WINDOW; i++) {
+        mean += warmup->thpt[i];
+    }
+    mean /= VMOPS_WARMUP_WINDOW;
+
+    double var = 0;
+    for (uint32_t i = 0; i < VMOPS_WARMUP_WINDOW; i++) {
+        var += (warmup->thpt[i] - mean) * (warmup->thpt[i] - mean);
+    }
+    var /= VMOPS_WARMUP_WINDOW;
+
+    /* compare the coefficient of variation against the threshold in percent */
+    double limit = mean * args->cfg->steady_cv / 100.0;
+    return mean > 0 && var < limit * limit;
+}
+
+
+/**
+ * @brief checks for the end of the warmup phase and resets the measurements of the thread
+ *
+ * @param args      the arguments of the thread
+ * @param t_current the current time
+ * @param counter   the operation counter of the thread
+ * @param t_start   the start of the measured window
+ * @param t_end     the end of the measured window
+ */
+void vmops_utils_warmup_poll(struct vmops_bench_run_arg *args, plat_time_t t_current,
+                             size_t *counter, plat_time_t *t_start, plat_time_t *t_end)
+{
+    struct vmops_warmup *warmup = args->warmup;
+    struct vmops_bench_cfg *cfg = args->cfg;
+
+    /* the thread that ends the warmup sets the common end of the measured window */
+    plat_time_t t_delta = plat_convert_time(cfg->time_ms);
+    plat_time_t t_window_end = t_delta == 0 ? PLAT_TIME_MAX : t_current + t_delta;
+    plat_time_t expected = 0;
+
+    bool done = __atomic_load_n(&warmup->t_end, __ATOMIC_ACQUIRE) != 0;
+
+    /* the deadline is checked by all threads, the steady state only by the first one */
+    if (!done && t_current >= warmup->t_deadline) {
+        if (__atomic_compare_exchange_n(&warmup->t_end, &expected, t_window_end, false,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+            if (cfg->steady_cv > 0) {
+                LOG_WARN("no steady state reached. warmup ended after %.3f ms\n",
+                         plat_time_to_ms(t_current - *t_start));
+            } else {
+                LOG_INFO("warmup ended after %.3f ms\n", plat_time_to_ms(t_current - *t_start));
+            }
+        }
+        done = true;
+    } else if (!done && args->tid == 0 && cfg->steady_cv > 0) {
+        if (utils_warmup_steady(args, t_current)) {
+            if (__atomic_compare_exchange_n(&warmup->t_end, &expected, t_window_end, false,
+                                            __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+                LOG_INFO("steady state reached. warmup ended after %.3f ms\n",
+                         plat_time_to_ms(t_current - *t_start));
+            }
+            done = true;
+        }
+    }
+
+    if (!done) {
+        *t_end = PLAT_TIME_MAX;
+        return;
+    }
+
+    args->stats.warmup = false;
+
+    /* start the measured window of this thread, it ends together with all other threads */
+    *counter = 0;
+    *t_start = t_current;
+    *t_end = __atomic_load_n(&warmup->t_end, __ATOMIC_ACQUIRE);
+
+    struct vmops_stats *stats = &args->stats;
+    __atomic_store_n(&stats->progress->ops, 0, __ATOMIC_RELAXED);
+    stats->idx = 0;
+    for (uint32_t op = 0; op < VMOPS_OP_MAX; op++) {
+        vmops_hist_reset(&stats->hist[op]);
+        stats->sampling_next[op] = 0;
+    }
+
+    if (args->perfctr != NULL) {
+        plat_perfctr_read(args->perfctr, args->perfctr_start);
+    }
+
+    if (args->irqstats != NULL) {
+        if (plat_irqstats_read(args->irqstats, &args->irqcounts[0]) != PLAT_ERR_OK) {
+            LOG_WARN("could not read the interrupt counts\n");
+        }
+    }
 }
@@ -9,6 +9,7 @@
 #define __VMOPS_BENCH_UTILS_H_ 1
 
 #include "benchmarks.h"
+#include "trace.h"
 
 
 /*
@@ -105,6 +106,94 @@ int vmops_utils_run_benchmark(uint32_t nthreads, struct vmops_bench_run_arg *arg
                               plat_thread_fn_t runfn);
 
 
+/**
+ * @brief starts the measured window of a benchmark thread
+ *
+ * @param args  the arguments of the thread
+ *
+ * @returns the start time of the measured window, common to all threads
+ *
+ * Waits on the barrier for all threads to be ready and spins until the common start of the
+ * window, such that all threads share the same start and deadline. Takes the start snapshot
+ * of the performance counters and records how late the thread woke up.
+ */
+plat_time_t vmops_utils_window_begin(struct vmops_bench_run_arg *args);
+
+
+/**
+ * @brief ends the measured window of a benchmark thread
+ *
+ * @param args  the arguments of the thread
+ *
+ * Records the performance counter deltas and waits on the barrier for all threads to finish.
+ */
+void vmops_utils_window_end(struct vmops_bench_run_arg *args);
+
+
+/**
+ * @brief checks for the end of the warmup phase and resets the measurements of the thread
+ *
+ * @param args      the arguments of the thread
+ * @param t_current the current time
+ * @param counter   the operation counter of the thread
+ * @param t_start   the start of the measured window
+ * @param t_end     the end of the measured window
+ *
+ * Use vmops_utils_warmup() instead.
+ */
+void vmops_utils_warmup_poll(struct vmops_bench_run_arg *args, plat_time_t t_current,
+                             size_t *counter, plat_time_t *t_start, plat_time_t *t_end);
+
+
+/**
+ * @brief handles the warmup phase of a benchmark thread, to be called after every operation
+ *
+ * @param args      the arguments of the thread
+ * @param t_current the current time
+ * @param counter   the operation counter of the thread
+ * @param t_start   the start of the measured window
+ * @param t_end     the end of the measured window
+ *
+ * While the warmup lasts the measured window is kept open. Once the warmup has ended, the
+ * counter, the window and the statistics of the thread are reset, and the window is extended
+ * to the configured benchmark time.
+ */
+static inline void vmops_utils_warmup(struct vmops_bench_run_arg *args, plat_time_t t_current,
+                                      size_t *counter, plat_time_t *t_start, plat_time_t *t_end)
+{
+    if (args->stats.warmup) {
+        vmops_utils_warmup_poll(args, t_current, counter, t_start, t_end);
+    }
+}
+
+
+/*
+ * ================================================================================================
+ * Random Numbers
+ * ================================================================================================
+ */
+
+
+/**
+ * @brief obtains the next number of a xorshift64 pseudo-random number generator
+ *
+ * @param state     the state of the generator, must not be zero
+ *
+ * @returns the next pseudo-random number
+ *
+ * The generator is cheap enough to be used between the timed operations of a thread.
+ */
+static inline uint64_t vmops_utils_rand(uint64_t *state)
+{
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+
 /*
  * ================================================================================================
  * Address Mapping Offset
@@ -114,6 +203,10 @@ int vmops_utils_run_benchmark(uint32_t nthreads, struct vmops_bench_run_arg *arg
 #define ADDRESS_OFFSET (512UL << 30)
 #define ADDRESS_REGION_OFFSET (256UL << 30)
 
+///< the region below the isolated mappings that holds the population of the address space
+#define POPULATION_ADDRESS ADDRESS_OFFSET
+#define POPULATION_REGION_SIZE (ADDRESS_OFFSET + ADDRESS_REGION_OFFSET)
+
 static inline void *utils_vmops_get_map_address(uint32_t tid)
 {
     return (void *)(ADDRESS_OFFSET * (tid + 2) + ADDRESS_REGION_OFFSET);
@@ -127,26 +220,115 @@ static inline void *utils_vmops_get_map_address(uint32_t tid)
  */
 
 
-static inline void vmops_utils_add_stats(struct vmops_stats *stats, uint32_t tid, uint64_t ops,
-                                         plat_time_t t_elapsed, plat_time_t val)
+/**
+ * @brief obtains the start time of the next operation
+ *
+ * @param stats     the statistics of the thread
+ * @param t_current the current time
+ *
+ * @returns the time the latency of the next operation is measured from
+ *
+ * In the default closed-loop mode this is the current time. With a target operation rate the
+ * thread waits for the intended start of the next operation and returns it. When the thread
+ * falls behind schedule, the intended start lies in the past and the queueing delay becomes
+ * part of the recorded latency instead of being omitted.
+ */
+static inline plat_time_t vmops_utils_op_start(struct vmops_stats *stats, plat_time_t t_current)
 {
-    if (stats->dryrun) {
-        stats->dryrun--;
-        return;
+    if (stats->pacing_delta == 0) {
+        return t_current;
     }
 
-    if (stats->sampling_next > t_elapsed) {
-        return;
+    if (stats->pacing_next == 0) {
+        stats->pacing_next = t_current;
+    }
+
+    plat_time_t t_intended = stats->pacing_next;
+    stats->pacing_next += stats->pacing_delta;
+
+    while (t_current < t_intended) {
+        t_current = plat_get_time();
     }
 
-    if (stats->idx == stats->idx_max) {
+    return t_intended;
+}
+
+
+static inline void vmops_utils_add_stats(struct vmops_stats *stats, vmops_op_t op, uint32_t tid,
+                                         uint64_t ops, plat_time_t t_elapsed, plat_time_t val)
+{
+    __atomic_store_n(&stats->progress->ops, ops, __ATOMIC_RELAXED);
+
+    vmops_hist_record(&stats->hist[op], val);
+
+    if (stats->warmup || stats->sampling_next[op] > t_elapsed) {
         return;
     }
 
-    stats->values[stats->idx] = (struct statval) { tid, t_elapsed, ops, val };
-    stats->idx++;
-    stats->sampling_next = t_elapsed + stats->sampling_delta;
+    struct statval sample = { tid, op, t_elapsed, ops, val };
+    stats->sampling_next[op] = t_elapsed + stats->sampling_delta;
+
+    /* the trace captures all samples, the values array only up to its size */
+    if (stats->ring != NULL) {
+        vmops_trace_push(stats->ring, &sample);
+    }
+
+    if (stats->idx < stats->idx_max) {
+        stats->values[stats->idx++] = sample;
+    }
 }
 
 
+/**
+ * @brief parses the name of a memory object backend
+ *
+ * @param name  the name of the backend
+ * @param type  returns the backend
+ *
+ * @returns 0 on success, -1 if the name is unknown
+ */
+int vmops_utils_parse_memobj(const char *name, plat_memobj_type_t *type);
+
+
+/**
+ * @brief obtains the name of the memory objects of the benchmark for the csv
+ *
+ * @param cfg   the benchmark configuration
+ *
+ * @returns the sharing and the backend of the memory objects
+ */
+const char *vmops_utils_memobj_name(struct vmops_bench_cfg *cfg);
+
+
+/**
+ * @brief parses the name of a page size
+ *
+ * @param name  the name of the page size
+ * @param page  returns the pages
+ *
+ * @returns 0 on success, -1 if the name is unknown
+ */
+int vmops_utils_parse_pages(const char *name, plat_page_t *page);
+
+
+/**
+ * @brief obtains the name of the page size of the benchmark for the csv
+ *
+ * @param cfg   the benchmark configuration
+ *
+ * @returns the size of the pages the kernel backed the mappings with
+ */
+const char *vmops_utils_page_size_name(struct vmops_bench_cfg *cfg);
+
+
+/**
+ * @brief obtains the name of an operation type
+ *
+ * @param op    the operation type
+ *
+ * @returns string representation of the operation
+ */
+const char *vmops_utils_op_name(vmops_op_t op);
+
+
 #endif /* __VMOPS_BENCH_UTILS_H_ */
\ No newline at end of file
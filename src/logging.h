@@ -66,12 +66,138 @@
 
 
 #define RESULT_FMT_STRING                                                                         \
-    "benchmark=%s, memsize=%zu, time=%.2f, ncores=%d, ops=%zu, thpt=%.2f, lat=%.4f"
+    "benchmark=%s, memsize=%zu, time=%.2f, ncores=%d, ops=%zu, thpt=%.2f, lat=%.6f, "            \
+    "p50=%.6f, p90=%.6f, p99=%.6f, p999=%.6f, max=%.6f"
 
-#define LOG_RESULT(_b, _m, _t, _n, _o, _thpt, _lat)                                                \
+#define LOG_RESULT(_b, _m, _t, _n, _o, _thpt, _lat, _hist)                                         \
     fprintf(stderr,                                                                                \
             VMOPS_PRINT_PREFIX COLOR_RESULT "RESULT [[ " RESULT_FMT_STRING " ]]" COLOR_RESET "\n", \
-            _b, _m, _t, _n, _o, _thpt, _lat)
+            _b, _m, _t, _n, _o, _thpt, _lat, plat_time_to_ms(vmops_hist_percentile(_hist, 50.0)), \
+            plat_time_to_ms(vmops_hist_percentile(_hist, 90.0)),                                   \
+            plat_time_to_ms(vmops_hist_percentile(_hist, 99.0)),                                   \
+            plat_time_to_ms(vmops_hist_percentile(_hist, 99.9)),                                   \
+            plat_time_to_ms(vmops_hist_percentile(_hist, 100.0)))
+
+#define RESULT_OP_FMT_STRING                                                                      \
+    "benchmark=%s, op=%s, count=%" PRIu64 ", lat=%.6f, p50=%.6f, p90=%.6f, p99=%.6f, "           \
+    "p999=%.6f, max=%.6f"
+
+#define LOG_RESULT_OP(_b, _op, _hist)                                                             \
+    fprintf(stderr,                                                                               \
+            VMOPS_PRINT_PREFIX COLOR_RESULT "LATENCY [[ " RESULT_OP_FMT_STRING " ]]" COLOR_RESET  \
+                                            "\n",                                                 \
+            _b, _op, (_hist)->count, plat_time_to_ms(vmops_hist_mean(_hist)),                     \
+            plat_time_to_ms(vmops_hist_percentile(_hist, 50.0)),                                  \
+            plat_time_to_ms(vmops_hist_percentile(_hist, 90.0)),                                  \
+            plat_time_to_ms(vmops_hist_percentile(_hist, 99.0)),                                  \
+            plat_time_to_ms(vmops_hist_percentile(_hist, 99.9)),                                  \
+            plat_time_to_ms(vmops_hist_percentile(_hist, 100.0)))
+
+#define LOG_RESULT_REP(_b, _r, _thpt)                                                             \
+    fprintf(stderr,                                                                               \
+            VMOPS_PRINT_PREFIX COLOR_RESULT "REP [[ benchmark=%s, rep=%u, thpt=%.2f ]]"           \
+                                            COLOR_RESET "\n",                                     \
+            _b, _r, _thpt)
+
+#define RESULT_REPS_FMT_STRING                                                                    \
+    "benchmark=%s, reps=%u, mean=%.2f, stddev=%.2f, ci95=%.2f, ci95_pct=%.2f, min=%.2f, "         \
+    "max=%.2f"
+
+#define LOG_RESULT_REPS(_b, _n, _mean, _stddev, _ci, _min, _max)                                  \
+    fprintf(stderr,                                                                               \
+            VMOPS_PRINT_PREFIX COLOR_RESULT "REPS [[ " RESULT_REPS_FMT_STRING " ]]" COLOR_RESET   \
+                                            "\n",                                                 \
+            _b, _n, _mean, _stddev, _ci, (_mean) > 0 ? (_ci)*100.0 / (_mean) : 0.0, _min, _max)
+
+#define RESULT_SKEW_FMT_STRING                                                                    \
+    "benchmark=%s, wake_max=%.6f, late_max=%.6f, late_threads=%u, ncores=%u"
+
+#define LOG_RESULT_SKEW(_b, _wake, _late, _nlate, _n)                                             \
+    fprintf(stderr,                                                                               \
+            VMOPS_PRINT_PREFIX COLOR_RESULT "SKEW [[ " RESULT_SKEW_FMT_STRING " ]]" COLOR_RESET   \
+                                            "\n",                                                 \
+            _b, _wake, _late, _nlate, _n)
+
+#define RESULT_VICTIMS_FMT_STRING                                                                 \
+    "benchmark=%s, unmappers=%u, victims=%d, pages=%u, accesses=%zu, thpt=%.2f"
+
+#define LOG_RESULT_VICTIMS(_b, _u, _v, _p, _a, _thpt)                                             \
+    fprintf(stderr,                                                                               \
+            VMOPS_PRINT_PREFIX COLOR_RESULT "VICTIMS [[ " RESULT_VICTIMS_FMT_STRING " ]]"         \
+                                            COLOR_RESET "\n",                                     \
+            _b, _u, _v, _p, _a, _thpt)
+
+#define RESULT_SYNC_FMT_STRING                                                                    \
+    "benchmark=%s, pages=%zu, dirty_per_page=%.6f, sync_per_page=%.6f, thpt=%.2f"
+
+#define LOG_RESULT_SYNC(_b, _p, _dirty, _sync, _thpt)                                             \
+    fprintf(stderr,                                                                               \
+            VMOPS_PRINT_PREFIX COLOR_RESULT "MSYNC [[ " RESULT_SYNC_FMT_STRING " ]]" COLOR_RESET  \
+                                            "\n",                                                 \
+            _b, _p, _dirty, _sync, _thpt)
+
+#define RESULT_SPLIT_FMT_STRING                                                                   \
+    "benchmark=%s, pages=%zu, stride=%u, vmas_before=%zu, vmas_split=%zu"
+
+#define LOG_RESULT_SPLIT(_b, _p, _s, _before, _split)                                             \
+    fprintf(stderr,                                                                               \
+            VMOPS_PRINT_PREFIX COLOR_RESULT "SPLIT [[ " RESULT_SPLIT_FMT_STRING " ]]" COLOR_RESET  \
+                                            "\n",                                                 \
+            _b, _p, _s, _before, _split)
+
+#define RESULT_MIX_FMT_STRING                                                                     \
+    "benchmark=%s, op=%s, count=%zu, share=%.2f, thpt=%.2f"
+
+#define LOG_RESULT_MIX(_b, _op, _n, _share, _thpt)                                                \
+    fprintf(stderr,                                                                               \
+            VMOPS_PRINT_PREFIX COLOR_RESULT "MIX [[ " RESULT_MIX_FMT_STRING " ]]" COLOR_RESET     \
+                                            "\n",                                                 \
+            _b, _op, _n, _share, _thpt)
+
+#define RESULT_REPLAY_FMT_STRING                                                                  \
+    "benchmark=%s, records=%zu, slots=%u, passes=%zu, lag_max=%.6f"
+
+#define LOG_RESULT_REPLAY(_b, _r, _s, _p, _lag)                                                   \
+    fprintf(stderr,                                                                               \
+            VMOPS_PRINT_PREFIX COLOR_RESULT "REPLAY [[ " RESULT_REPLAY_FMT_STRING " ]]"           \
+                                            COLOR_RESET "\n",                                     \
+            _b, _r, _s, _p, _lag)
+
+#define RESULT_VMAS_FMT_STRING                                                                    \
+    "benchmark=%s, mappings=%zu, vmas=%zu, op=%s, lat=%.6f, p50=%.6f, p90=%.6f, p99=%.6f, "      \
+    "max=%.6f"
+
+#define LOG_RESULT_VMAS(_b, _m, _v, _op, _hist)                                                   \
+    fprintf(stderr,                                                                               \
+            VMOPS_PRINT_PREFIX COLOR_RESULT "VMAS [[ " RESULT_VMAS_FMT_STRING " ]]" COLOR_RESET   \
+                                            "\n",                                                 \
+            _b, _m, _v, _op, plat_time_to_ms(vmops_hist_mean(_hist)),                             \
+            plat_time_to_ms(vmops_hist_percentile(_hist, 50.0)),                                  \
+            plat_time_to_ms(vmops_hist_percentile(_hist, 90.0)),                                  \
+            plat_time_to_ms(vmops_hist_percentile(_hist, 99.0)),                                  \
+            plat_time_to_ms(vmops_hist_percentile(_hist, 100.0)))
+
+#define RESULT_IPI_FMT_STRING                                                                     \
+    "benchmark=%s, tlb_shootdowns=%" PRIu64 ", shootdowns_per_op=%.4f, ipis_per_core=%.2f"
+
+#define LOG_RESULT_IPI(_b, _shootdowns, _ops, _ipis, _n)                                          \
+    fprintf(stderr,                                                                               \
+            VMOPS_PRINT_PREFIX COLOR_RESULT "IPI [[ " RESULT_IPI_FMT_STRING " ]]" COLOR_RESET     \
+                                            "\n",                                                 \
+            _b, (uint64_t)(_shootdowns),                                                          \
+            (_ops) ? (double)(_shootdowns) / (double)(_ops) : 0.0, (double)(_ipis) / (_n))
+
+#define RESULT_TLBFLUSH_FMT_STRING                                                                \
+    "benchmark=%s, task_switch=%" PRIu64 ", remote_shootdown=%" PRIu64                           \
+    ", local_shootdown=%" PRIu64 ", local_mm_shootdown=%" PRIu64 ", remote_send_ipi=%" PRIu64
+
+#define LOG_RESULT_TLBFLUSH(_b, _flush)                                                           \
+    fprintf(stderr,                                                                               \
+            VMOPS_PRINT_PREFIX COLOR_RESULT "TLBFLUSH [[ " RESULT_TLBFLUSH_FMT_STRING             \
+                                            " ]]" COLOR_RESET "\n",                               \
+            _b, (_flush)[PLAT_TLBFLUSH_TASK_SWITCH], (_flush)[PLAT_TLBFLUSH_REMOTE_SHOOTDOWN],    \
+            (_flush)[PLAT_TLBFLUSH_LOCAL_SHOOTDOWN], (_flush)[PLAT_TLBFLUSH_LOCAL_MM_SHOOTDOWN],  \
+            (_flush)[PLAT_TLBFLUSH_REMOTE_SEND_IPI])
 
 
 /*
@@ -87,20 +213,37 @@ extern FILE *thptout;
 #define LOG_CSV_HEADER()                                                                          \
     fprintf(stderr, "===================== BEGIN CSV =====================\n");                   \
     fprintf(thptout, "thread_id,benchmark,core,ncores,memsize,numainterleave,mappings_size,page_" \
-                    "size,memobj,isolation,duration,operations\n");
+                     "size,memobj,isolation,duration,operations,cycles,instructions,dtlb_misses,"  \
+                     "itlb_misses,cycles_user,cycles_kernel,tlb_ipis,call_ipis\n");
 
 #define LOG_CSV_FOOTER()                                                                          \
     fprintf(stderr, "====================== END CSV ======================\n");
 
+///< the per-operation value of a performance counter, _ctr is indexed by plat_perfctr_event_t
+#define PERFCTR_PER_OP(_ctr, _e, _ops) ((_ops) ? (double)(_ctr)[_e] / (double)(_ops) : 0.0)
+
+///< the number of IPIs of a core, _ipi is indexed by plat_ipi_t and may be NULL
+#define IPIS_OF_CORE(_ipi, _e) ((_ipi) ? (_ipi)[_e] : 0)
+
 // If you modify the CSV format, also change the header-line in scripts/run.sh accordingly:
-#define LOG_CSV(_cfg, _t, _d, _tpt)                                                               \
-    fprintf(thptout, "%d,%s,%d,%d,%zu,%s,%s,%s,%s,%s,%.3f,%zu\n", _t, (_cfg)->benchmark,          \
-            (_cfg)->coreslist[_t], (_cfg)->corelist_size, (_cfg)->memsize,                        \
-            ((_cfg)->numainterleave ? "numainterleave" : "numafill"),                             \
+#define LOG_CSV(_cfg, _t, _d, _tpt, _ctr, _ipi)                                                   \
+    fprintf(thptout,                                                                              \
+            "%d,%s,%d,%d,%zu,%s,%s,%s,%s,%s,%.3f,%zu,%.2f,%.2f,%.4f,%.4f,%.2f,%.2f,%" PRIu64     \
+            ",%" PRIu64 "\n",                                                                     \
+            _t, (_cfg)->benchmark, (_cfg)->coreslist[_t], (_cfg)->corelist_size,                  \
+            (_cfg)->memsize, ((_cfg)->numainterleave ? "numainterleave" : "numafill"),            \
             ((_cfg)->map4k ? "smallmappings" : "onelargemap"),                                    \
-            ((_cfg)->maphuge ? "hugepages" : "basepages"),                                        \
-            ((_cfg)->shared ? "shared-memobj" : "independent-memobj"),                            \
-            ((_cfg)->isolated ? "isolated" : "default"), _d, _tpt);
+            vmops_utils_page_size_name(_cfg),                                                     \
+            vmops_utils_memobj_name(_cfg),                                                        \
+            ((_cfg)->isolated ? "isolated" : "default"), _d, _tpt,                                \
+            PERFCTR_PER_OP(_ctr, PLAT_PERFCTR_CYCLES, _tpt),                                      \
+            PERFCTR_PER_OP(_ctr, PLAT_PERFCTR_INSTRUCTIONS, _tpt),                                \
+            PERFCTR_PER_OP(_ctr, PLAT_PERFCTR_DTLB_MISSES, _tpt),                                 \
+            PERFCTR_PER_OP(_ctr, PLAT_PERFCTR_ITLB_MISSES, _tpt),                                 \
+            PERFCTR_PER_OP(_ctr, PLAT_PERFCTR_CYCLES_USER, _tpt),                                 \
+            PERFCTR_PER_OP(_ctr, PLAT_PERFCTR_CYCLES_KERNEL, _tpt),                               \
+            IPIS_OF_CORE(_ipi, PLAT_IPI_TLB_SHOOTDOWN),                                           \
+            IPIS_OF_CORE(_ipi, PLAT_IPI_FUNCTION_CALL));
 
 
 /*
@@ -117,26 +260,106 @@ extern FILE *latout;
 #define LOG_STATS_HEADER()                                                                        \
     fprintf(stderr, "====================== BEGIN STATS ======================\n");               \
     fprintf(latout, "benchmark,core,ncores,memsize,numainterleave,mappings_size,page_"           \
-                    "size,memobj,isolation,threadid,elapsed,couter,latency\n");
+                    "size,memobj,isolation,threadid,op,elapsed,couter,latency\n");
 
 #define LOG_STATS_FOOTER()                                                                        \
     fprintf(stderr, "====================== END STATS ======================\n");
 
 
+// prints a sample with the elapsed time and the latency already converted to ms
+#define LOG_STATS_MS(_cfg, stat, _elapsed, _latency)                                              \
+    fprintf(latout, "%s,%d,%d,%zu,%s,%s,%s,%s,%s,%d,%s,%f,%" PRIu64 ",%f\n", (_cfg)->benchmark,   \
+            (_cfg)->coreslist[(stat).tid], (_cfg)->corelist_size, (_cfg)->memsize,                \
+            ((_cfg)->numainterleave ? "numainterleave" : "numafill"),                             \
+            ((_cfg)->map4k ? "smallmappings" : "onelargemap"),                                    \
+            vmops_utils_page_size_name(_cfg),                                                     \
+            vmops_utils_memobj_name(_cfg),                                                        \
+            ((_cfg)->isolated ? "isolated" : "default"), (stat).tid,                              \
+            vmops_utils_op_name((stat).op), _elapsed, (stat).counter, _latency)
+
 #define LOG_STATS(_cfg, n, stat)                                                                  \
     do {                                                                                          \
         if ((stat).t_elapsed != 0 && (stat).val != 0) {                                           \
-            fprintf(latout, "%s,%d,%d,%zu,%s,%s,%s,%s,%s,%d,%f,%" PRIu64 ",%f\n",                 \
-                    (_cfg)->benchmark, (_cfg)->coreslist[(stat).tid], (_cfg)->corelist_size,      \
-                    (_cfg)->memsize, ((_cfg)->numainterleave ? "numainterleave" : "numafill"),    \
+            LOG_STATS_MS(_cfg, stat, plat_time_to_ms((stat).t_elapsed),                           \
+                         plat_time_to_ms((stat).val));                                            \
+        }                                                                                         \
+    } while (0)
+
+
+/*
+ * ================================================================================================
+ * Printing of Benchmark Latency Percentiles in CSV
+ * ================================================================================================
+ */
+
+
+///< file set to where the latency percentiles csv is printed, defined in main.c. may be NULL
+extern FILE *histout;
+
+#define LOG_HIST_HEADER()                                                                         \
+    fprintf(histout, "benchmark,core,ncores,memsize,numainterleave,mappings_size,page_size,"     \
+                     "memobj,isolation,threadid,op,count,min,mean,p50,p90,p99,p999,max\n");
+
+// prints the latency summary of an operation on a thread, or on all threads if _t is -1
+#define LOG_HIST(_cfg, _t, _op, _hist)                                                            \
+    do {                                                                                          \
+        if ((_hist)->count != 0) {                                                                \
+            fprintf(histout, "%s,%d,%d,%zu,%s,%s,%s,%s,%s,%d,%s,%" PRIu64                         \
+                             ",%f,%f,%f,%f,%f,%f,%f\n",                                           \
+                    (_cfg)->benchmark, (_t) < 0 ? -1 : (int)(_cfg)->coreslist[_t],               \
+                    (_cfg)->corelist_size, (_cfg)->memsize,                                       \
+                    ((_cfg)->numainterleave ? "numainterleave" : "numafill"),                     \
                     ((_cfg)->map4k ? "smallmappings" : "onelargemap"),                            \
-                    ((_cfg)->maphuge ? "hugepages" : "basepages"),                                \
-                    ((_cfg)->shared ? "shared-memobj" : "independent-memobj"),                    \
-                    ((_cfg)->isolated ? "isolated" : "default"), (stat).tid,                      \
-                    plat_time_to_ms((stat).t_elapsed), (stat).counter,                            \
-                    plat_time_to_ms((stat).val));                                                 \
+                    vmops_utils_page_size_name(_cfg),                                             \
+                    vmops_utils_memobj_name(_cfg),                                                \
+                    ((_cfg)->isolated ? "isolated" : "default"), (int)(_t),                       \
+                    vmops_utils_op_name(_op), (_hist)->count,                                     \
+                    plat_time_to_ms((_hist)->min), plat_time_to_ms(vmops_hist_mean(_hist)),       \
+                    plat_time_to_ms(vmops_hist_percentile(_hist, 50.0)),                          \
+                    plat_time_to_ms(vmops_hist_percentile(_hist, 90.0)),                          \
+                    plat_time_to_ms(vmops_hist_percentile(_hist, 99.0)),                          \
+                    plat_time_to_ms(vmops_hist_percentile(_hist, 99.9)),                          \
+                    plat_time_to_ms((_hist)->max));                                               \
         }                                                                                         \
     } while (0)
 
 
+/*
+ * ================================================================================================
+ * Printing of the Benchmark Time Series in CSV
+ * ================================================================================================
+ */
+
+
+///< file set to where the time series csv is printed, defined in main.c
+extern FILE *tsout;
+
+#define LOG_TS_HEADER()                                                                           \
+    fprintf(tsout, "benchmark,ncores,elapsed,threadid,core,ops,thpt,count,p50,p90,p99,p999,"     \
+                   "max\n");
+
+// prints the progress of a thread during the last interval, or of all threads if _t is -1
+#define LOG_TS(_cfg, _elapsed, _t, _ops, _interval, _hist)                                        \
+    fprintf(tsout, "%s,%d,%.3f,%d,%d,%" PRIu64 ",%.2f,%" PRIu64 ",%f,%f,%f,%f,%f\n",              \
+            (_cfg)->benchmark, (_cfg)->corelist_size, _elapsed, (int)(_t),                        \
+            (_t) < 0 ? -1 : (int)(_cfg)->coreslist[_t], (uint64_t)(_ops),                         \
+            (double)(_ops)*1000.0 / (_interval), (_hist)->count,                                  \
+            plat_time_to_ms(vmops_hist_percentile(_hist, 50.0)),                                  \
+            plat_time_to_ms(vmops_hist_percentile(_hist, 90.0)),                                  \
+            plat_time_to_ms(vmops_hist_percentile(_hist, 99.0)),                                  \
+            plat_time_to_ms(vmops_hist_percentile(_hist, 99.9)),                                  \
+            plat_time_to_ms(vmops_hist_percentile(_hist, 100.0)));
+
+
+/*
+ * ================================================================================================
+ * Printing of the Benchmark Result Record in JSON
+ * ================================================================================================
+ */
+
+
+///< file set to where the json result record is appended, NULL if disabled, defined in main.c
+extern FILE *jsonout;
+
+
 #endif /* __VMOPS_LOGGING_H_ */
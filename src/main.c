@@ -15,6 +15,8 @@
 
 #include "logging.h"
 #include "benchmarks/benchmarks.h"
+#include "benchmarks/trace.h"
+#include "benchmarks/utils.h"
 
 
 #define THPOUT_DEFAULT stdout
@@ -23,6 +25,13 @@ FILE *thptout = NULL;
 #define LATOUT_DEFAULT stdout
 FILE *latout = NULL;
 
+FILE *histout = NULL;
+
+#define TSOUT_DEFAULT stdout
+FILE *tsout = NULL;
+
+FILE *jsonout = NULL;
+
 static struct vmops_bench_cfg cfg = { .memsize = 4096,
                                       .coreslist = NULL,
                                       .corelist_size = 0,
@@ -31,8 +40,31 @@ static struct vmops_bench_cfg cfg = { .memsize = 4096,
                                       .nounmap = false,
                                       .nops = 0,
                                       .rate = -1,
+                                      .timer = PLAT_TIMER_DEFAULT,
+                                      .perfctr = false,
+                                      .sampler_ms = 0,
+                                      .warmup_ms = 0,
+                                      .steady_cv = 0,
+                                      .reps = 1,
+                                      .reps_ci = 0,
+                                      .tracefile = NULL,
+                                      .unmappers = 1,
+                                      .victims = -1,
+                                      .victim_pages = 1,
+                                      .unmap_batch = 1,
+                                      .fault = VMOPS_FAULT_WRITE,
+                                      .split = VMOPS_SPLIT_NONE,
+                                      .split_stride = 2,
+                                      .mix = NULL,
+                                      .seed = 0,
+                                      .replayfile = NULL,
+                                      .replaytimed = false,
+                                      .population = BENCHMARK_PREPOPULATE_MAPPINGS,
+                                      .population_max = 0,
+                                      .memobj = PLAT_MEMOBJ_MEMFD,
+                                      .memobj_dir = "/var/tmp",
                                       .map4k = false,
-                                      .maphuge = false,
+                                      .pages = PLAT_PAGE_BASE,
                                       .isolated = false,
                                       .shared = true,
                                       .numainterleave = false };
@@ -103,6 +135,113 @@ static int parse_cores_list(char *cores, uint32_t **retcoreslist, uint32_t *ncor
 static void print_help(const char *bin)
 {
     fprintf(stderr, "Usage: %s [-c coreslist] [-m memsize] [-b benchmark] [-p nproc]...\n", bin);
+    fprintf(stderr, "  -a ops/s           open-loop mode with a target rate per thread\n");
+    fprintf(stderr, "  -A ops/s           open-loop mode with a target rate for all threads\n");
+    fprintf(stderr, "  -e                 record per-thread hardware performance counters\n");
+    fprintf(stderr, "  -H file            append per-thread latency percentiles to file\n");
+    fprintf(stderr, "  -S ms              sample the progress of all threads every ms\n");
+    fprintf(stderr, "  -W file            append the sampled time series to file\n");
+    fprintf(stderr, "  -w ms              warm up for ms before measuring\n");
+    fprintf(stderr, "  -v cv              warm up until the throughput varies less than cv %%\n");
+    fprintf(stderr, "  -R reps            repeat the benchmark reps times\n");
+    fprintf(stderr, "  -C ci              repeat until the 95%% ci is within ci %% of the mean\n");
+    fprintf(stderr, "  -L file            stream all latency samples to a binary trace file\n");
+    fprintf(stderr, "  -J file            append the result record as a line of json to file\n");
+    fprintf(stderr, "  -D file            convert a binary trace file into the latency csv\n");
+    fprintf(stderr, "  -U n               tlbshoot: number of unmapping threads (default 1)\n");
+    fprintf(stderr, "  -V n               tlbshoot: number of victim threads (default rest)\n");
+    fprintf(stderr, "  -P pages           tlbshoot: number of pages each victim touches\n");
+    fprintf(stderr, "  -K pages           tlbshoot-4k: number of pages unmapped per call\n");
+    fprintf(stderr, "  -M memobj          memfd, anon, anonshared, shm, file or filealloc\n");
+    fprintf(stderr, "  -F dir             directory of the file memory objects\n");
+    fprintf(stderr, "  -g pages           4k, 2m, 1g or thp, -l is the same as -g 2m\n");
+    fprintf(stderr, "  -N n               protectsplit: protect every n-th page (default 2)\n");
+    fprintf(stderr, "  -B n               populate the address space with n mappings (default %d)"
+                    "\n", BENCHMARK_PREPOPULATE_MAPPINGS);
+    fprintf(stderr, "  -X n               sweep the population over 0, 1, 10, 100, ... up to n\n");
+    fprintf(stderr, "                     the trace of -L goes to file.<population> per step\n");
+    fprintf(stderr, "  -O mix             mix: op:weight,... of map, unmap, protect, fault or\n");
+    fprintf(stderr, "                     discard, mixes for the threads separated by '/'\n");
+    fprintf(stderr, "  -Q seed            mix: seed of the random operation picks (default 0)\n");
+    fprintf(stderr, "  -Y file            replay: the trace of operations to be replayed\n");
+    fprintf(stderr, "  -T tsc|monotonic   time source for the measurements\n");
+}
+
+/**
+ * @brief runs the selected benchmark with the global configuration
+ *
+ * @returns 0 success, -1 error
+ */
+static int run_benchmark(void)
+{
+    int r = 0;
+    if (strncmp(cfg.benchmark, "mapunmap", 8) == 0) {
+        /* map and unmap of memory */
+        r = vmpos_bench_run_mapunmap(&cfg, cfg.benchmark + 8);
+    } else if (strncmp(cfg.benchmark, "maponly", 7) == 0) {
+        /* map only benchmark */
+        cfg.nounmap = true;
+        r = vmpos_bench_run_mapunmap(&cfg, cfg.benchmark + 7);
+    } else if (strncmp(cfg.benchmark, "protectsplitrandom", 18) == 0) {
+        /* split and merge a mapping at a random page */
+        cfg.split = VMOPS_SPLIT_RANDOM;
+        r = vmops_bench_run_protect(&cfg, cfg.benchmark + 18);
+    } else if (strncmp(cfg.benchmark, "protectsplit", 12) == 0) {
+        /* split and merge a mapping at every n-th page */
+        cfg.split = VMOPS_SPLIT_STRIDE;
+        r = vmops_bench_run_protect(&cfg, cfg.benchmark + 12);
+    } else if (strncmp(cfg.benchmark, "protect", 7) == 0) {
+        /* protection benchmark */
+        r = vmops_bench_run_protect(&cfg, cfg.benchmark + 7);
+    } else if (strncmp(cfg.benchmark, "elevate", 7) == 0) {
+        /* protection benchmark */
+        r = vmops_bench_run_protect_elevate(&cfg, cfg.benchmark + 7);
+    } else if (strncmp(cfg.benchmark, "faultread", 9) == 0) {
+        /* read faults on demand-paged memory */
+        cfg.fault = VMOPS_FAULT_READ;
+        r = vmops_bench_run_fault(&cfg, cfg.benchmark + 9);
+    } else if (strncmp(cfg.benchmark, "faultwrite", 10) == 0) {
+        /* write faults on demand-paged memory */
+        cfg.fault = VMOPS_FAULT_WRITE;
+        r = vmops_bench_run_fault(&cfg, cfg.benchmark + 10);
+    } else if (strncmp(cfg.benchmark, "faultrw", 7) == 0) {
+        /* write after read faults on demand-paged memory */
+        cfg.fault = VMOPS_FAULT_READ_WRITE;
+        r = vmops_bench_run_fault(&cfg, cfg.benchmark + 7);
+    } else if (strncmp(cfg.benchmark, "mremapgrow", 10) == 0) {
+        /* shrink and grow a mapping in place */
+        cfg.remap = PLAT_REMAP_RESIZE;
+        r = vmops_bench_run_mremap(&cfg, cfg.benchmark + 10);
+    } else if (strncmp(cfg.benchmark, "mremapmove", 10) == 0) {
+        /* move a mapping between two addresses */
+        cfg.remap = PLAT_REMAP_MOVE;
+        r = vmops_bench_run_mremap(&cfg, cfg.benchmark + 10);
+    } else if (strncmp(cfg.benchmark, "mremapdontunmap", 15) == 0) {
+        /* move the pages of a mapping and keep the old range mapped */
+        cfg.remap = PLAT_REMAP_DONTUNMAP;
+        r = vmops_bench_run_mremap(&cfg, cfg.benchmark + 15);
+    } else if (strncmp(cfg.benchmark, "msync", 5) == 0) {
+        /* dirty pages and write them back */
+        r = vmops_bench_run_msync(&cfg, cfg.benchmark + 5);
+    } else if (strncmp(cfg.benchmark, "mix", 3) == 0) {
+        /* a random mix of operations on the live mappings of a thread */
+        r = vmops_bench_run_mix(&cfg, cfg.benchmark + 3);
+    } else if (strncmp(cfg.benchmark, "replaytimed", 11) == 0) {
+        /* replay a recorded trace of operations with its timing */
+        cfg.replaytimed = true;
+        r = vmops_bench_run_replay(&cfg, cfg.benchmark + 11);
+    } else if (strncmp(cfg.benchmark, "replay", 6) == 0) {
+        /* replay a recorded trace of operations as fast as possible */
+        cfg.replaytimed = false;
+        r = vmops_bench_run_replay(&cfg, cfg.benchmark + 6);
+    } else if (strncmp(cfg.benchmark, "tlbshoot", 8) == 0) {
+        r = vmops_bench_run_tlbshoot(&cfg, cfg.benchmark + 8);
+    } else {
+        LOG_ERR("unsupported benchmark '%s'\n", cfg.benchmark);
+        r = -1;
+    }
+
+    return r;
 }
 
 /**
@@ -119,18 +258,27 @@ int main(int argc, char *argv[])
 
     uint32_t ncores = 0;
     cfg.benchmark = "mapunmap";
+    cfg.argc = argc;
+    cfg.argv = argv;
 
     thptout = THPOUT_DEFAULT;
     latout = LATOUT_DEFAULT;
+    tsout = TSOUT_DEFAULT;
 
     plat_topo_numa_t numa_topology = PLAT_TOPOLOGY_NUMA_FILL;
     plat_topo_cores_t cores_topology = PLAT_TOPOLOGY_CORES_INTERLEAVE;
 
+    bool oprate_global = false;
+    const char *decodefile = NULL;
+
+    const char *optstring = "lis:p:t:c:m:n:b:r:o:z:a:A:eH:S:W:w:v:R:C:L:J:D:U:V:P:K:M:F:g:N:B:X:"
+                            "O:Q:Y:T:h";
+
     int opt;
-    while ((opt = getopt(argc, argv, "lis:p:t:c:m:n:b:r:o:z:h")) != -1) {
+    while ((opt = getopt(argc, argv, optstring)) != -1) {
         switch (opt) {
         case 'l':
-            cfg.maphuge = true;
+            cfg.pages = PLAT_PAGE_HUGE_2M;
             break;
         case 'p':
             ncores = strtoul(optarg, NULL, 10);
@@ -171,6 +319,116 @@ int main(int argc, char *argv[])
                 thptout = THPOUT_DEFAULT;
             }
             break;
+        case 'a':
+            cfg.oprate = strtoull(optarg, NULL, 10);
+            oprate_global = false;
+            break;
+        case 'A':
+            cfg.oprate = strtoull(optarg, NULL, 10);
+            oprate_global = true;
+            break;
+        case 'e':
+            cfg.perfctr = true;
+            break;
+        case 'H':
+            LOG_INFO("using '%s' as outfile for latency percentiles csv\n", optarg);
+            histout = fopen(optarg, "a");
+            if (histout == NULL) {
+                LOG_ERR("could not open file for writing, not printing the percentiles\n");
+            }
+            break;
+        case 'S':
+            cfg.sampler_ms = strtoul(optarg, NULL, 10);
+            break;
+        case 'W':
+            LOG_INFO("using '%s' as outfile for time series csv\n", optarg);
+            tsout = fopen(optarg, "a");
+            if (tsout == NULL) {
+                LOG_ERR("could not open file for writing, falling back to stdout\n");
+                tsout = TSOUT_DEFAULT;
+            }
+            break;
+        case 'w':
+            cfg.warmup_ms = strtoul(optarg, NULL, 10);
+            break;
+        case 'v':
+            cfg.steady_cv = strtod(optarg, NULL);
+            break;
+        case 'R':
+            cfg.reps = strtoul(optarg, NULL, 10);
+            break;
+        case 'C':
+            cfg.reps_ci = strtod(optarg, NULL);
+            break;
+        case 'L':
+            cfg.tracefile = optarg;
+            break;
+        case 'J':
+            LOG_INFO("using '%s' as outfile for the json result record\n", optarg);
+            jsonout = fopen(optarg, "a");
+            if (jsonout == NULL) {
+                LOG_ERR("could not open file for writing, not printing the json record\n");
+            }
+            break;
+        case 'U':
+            cfg.unmappers = strtoul(optarg, NULL, 10);
+            break;
+        case 'V':
+            cfg.victims = strtol(optarg, NULL, 10);
+            break;
+        case 'P':
+            cfg.victim_pages = strtoul(optarg, NULL, 10);
+            break;
+        case 'K':
+            cfg.unmap_batch = strtoul(optarg, NULL, 10);
+            break;
+        case 'D':
+            decodefile = optarg;
+            break;
+        case 'M':
+            if (vmops_utils_parse_memobj(optarg, &cfg.memobj)) {
+                LOG_ERR("unknown memory object '%s', expected 'memfd', 'anon', 'anonshared', "
+                        "'shm', 'file' or 'filealloc'\n", optarg);
+                exit(EXIT_FAILURE);
+            }
+            break;
+        case 'F':
+            cfg.memobj_dir = optarg;
+            break;
+        case 'N':
+            cfg.split_stride = strtoul(optarg, NULL, 10);
+            break;
+        case 'B':
+            cfg.population = strtoul(optarg, NULL, 10);
+            break;
+        case 'X':
+            cfg.population_max = strtoul(optarg, NULL, 10);
+            break;
+        case 'O':
+            cfg.mix = optarg;
+            break;
+        case 'Q':
+            cfg.seed = strtoull(optarg, NULL, 10);
+            break;
+        case 'Y':
+            cfg.replayfile = optarg;
+            break;
+        case 'g':
+            if (vmops_utils_parse_pages(optarg, &cfg.pages)) {
+                LOG_ERR("unknown page size '%s', expected '4k', '2m', '1g' or 'thp'\n", optarg);
+                exit(EXIT_FAILURE);
+            }
+            break;
+        case 'T':
+            if (strcmp(optarg, "tsc") == 0) {
+                cfg.timer = PLAT_TIMER_TSC;
+            } else if (strcmp(optarg, "monotonic") == 0) {
+                cfg.timer = PLAT_TIMER_MONOTONIC;
+            } else {
+                LOG_ERR("unknown timer '%s', expected 'tsc' or 'monotonic'\n", optarg);
+                exit(EXIT_FAILURE);
+            }
+            break;
         case 'z' :
             LOG_INFO("using '%s' as outfile for latency csv\n", optarg);
             latout = fopen (optarg,"a");
@@ -188,6 +446,14 @@ int main(int argc, char *argv[])
         }
     }
 
+    if (decodefile != NULL) {
+        int ret = vmops_trace_decode(decodefile);
+        if (latout != LATOUT_DEFAULT) {
+            fclose(latout);
+        }
+        exit(ret ? EXIT_FAILURE : EXIT_SUCCESS);
+    }
+
     // either the first ncores are selected, or a provided cores list
     if (ncores != 0 && cfg.coreslist != NULL) {
         LOG_ERR("Please provide either coreslist or number of cores.\n");
@@ -215,24 +481,39 @@ int main(int argc, char *argv[])
 
     plat_init(&cfg);
 
-    if ((cfg.corelist_size * cfg.memsize) > (32UL << 30)) {
-        LOG_WARN("estimate total required memory > 32GB!\n");
+    size_t pagesize = plat_page_size(cfg.pages);
+    if (cfg.memsize == 0 || cfg.memsize % pagesize) {
+        cfg.memsize = (cfg.memsize / pagesize + 1) * pagesize;
+        LOG_WARN("rounding memsize up to a multiple of the page size. memsize=%zu\n",
+                 cfg.memsize);
     }
 
-    if (cfg.maphuge && cfg.memsize < PLAT_ARCH_HUGE_PAGE_SIZE) {
-        LOG_WARN("increasing memsize to PLAT_ARCH_HUGE_PAGE_SIZE=%d\n", PLAT_ARCH_HUGE_PAGE_SIZE);
-        cfg.memsize = PLAT_ARCH_HUGE_PAGE_SIZE;
+    if ((cfg.corelist_size * cfg.memsize) > (32UL << 30)) {
+        LOG_WARN("estimate total required memory > 32GB!\n");
     }
 
     if (cfg.rate == -1) {
         cfg.rate = DEFAULT_SAMPLING_RATE_MS;
     }
 
+    if (oprate_global) {
+        cfg.oprate = cfg.oprate / cfg.corelist_size;
+        if (cfg.oprate == 0) {
+            LOG_WARN("global operation rate is below one op/s per thread, using 1 op/s\n");
+            cfg.oprate = 1;
+        }
+    }
+
     LOG_PRINT("==========================================================================\n");
     LOG_PRINT("benchmark: %s\n", cfg.benchmark);
     LOG_PRINT("memsize:   %zu\n", cfg.memsize);
     LOG_PRINT("time:      %d ms\n", cfg.time_ms);
     LOG_PRINT("nops:      %zu\n", cfg.nops);
+    if (cfg.oprate) {
+        LOG_PRINT("oprate:    %" PRIu64 " ops/s per thread (open loop)\n", cfg.oprate);
+    } else {
+        LOG_PRINT("oprate:    closed loop\n");
+    }
     LOG_PRINT("ncores:    %d\n", cfg.corelist_size);
     LOG_PRINT("cores:     [ %d", cfg.coreslist[0]);
     for (uint32_t i = 1; i < cfg.corelist_size; i++) {
@@ -241,26 +522,32 @@ int main(int argc, char *argv[])
     LOG_PRINT_END(" ]\n");
     LOG_PRINT("==========================================================================\n");
 
-    // select the benchmark to be run
-
     int r = 0;
-    if (strncmp(cfg.benchmark, "mapunmap", 8) == 0) {
-        /* map and unmap of memory */
-        r = vmpos_bench_run_mapunmap(&cfg, cfg.benchmark + 8);
-    } else if (strncmp(cfg.benchmark, "maponly", 7) == 0) {
-        /* map only benchmark */
-        cfg.nounmap = true;
-        r = vmpos_bench_run_mapunmap(&cfg, cfg.benchmark + 7);
-    } else if (strncmp(cfg.benchmark, "protect", 7) == 0) {
-        /* protection benchmark */
-        r = vmops_bench_run_protect(&cfg, cfg.benchmark + 7);
-    } else if (strncmp(cfg.benchmark, "elevate", 7) == 0) {
-        /* protection benchmark */
-        r = vmops_bench_run_protect_elevate(&cfg, cfg.benchmark + 7);
-    } else if (strncmp(cfg.benchmark, "tlbshoot", 8) == 0) {
-        r = vmops_bench_run_tlbshoot(&cfg, cfg.benchmark + 8);
+    if (cfg.population_max) {
+        /* the latency as a function of the number of mappings, on a logarithmic scale */
+        const char *tracefile = cfg.tracefile;
+        char tracebuf[256];
+
+        cfg.population = 0;
+        while (r == 0) {
+            /* the trace of each step goes to its own file */
+            if (tracefile != NULL) {
+                snprintf(tracebuf, sizeof(tracebuf), "%s.%zu", tracefile, cfg.population);
+                cfg.tracefile = tracebuf;
+            }
+
+            r = run_benchmark();
+            if (cfg.population >= cfg.population_max) {
+                break;
+            }
+
+            cfg.population = cfg.population ? cfg.population * 10 : 1;
+            if (cfg.population > cfg.population_max) {
+                cfg.population = cfg.population_max;
+            }
+        }
     } else {
-        LOG_ERR("unsupported benchmark '%s'\n", cfg.benchmark);
+        r = run_benchmark();
     }
 
     if (r) {
@@ -278,6 +565,21 @@ int main(int argc, char *argv[])
         fclose(latout);
     }
 
+    if (tsout != TSOUT_DEFAULT) {
+        fflush(tsout);
+        fclose(tsout);
+    }
+
+    if (histout != NULL) {
+        fflush(histout);
+        fclose(histout);
+    }
+
+    if (jsonout != NULL) {
+        fflush(jsonout);
+        fclose(jsonout);
+    }
+
     free(cfg.coreslist);
 
     return EXIT_SUCCESS;
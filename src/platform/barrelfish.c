@@ -317,11 +317,13 @@ static cslot_t memobj_slot = 0;
  * @param path      the name/path of the memobj
  * @param memobj    returns a pointer to the created memory object
  * @param size      the maximum size for the memory object
- * @param huge      use huge pages for this memory object
+ * @param page      the pages of the memory object
+ * @param type      the backend of the memory object
  *
  * @returns error value
  */
-plat_error_t plat_vm_create(const char *path, plat_memobj_t *memobj, size_t size, bool huge)
+plat_error_t plat_vm_create(const char *path, plat_memobj_t *memobj, size_t size,
+                            plat_page_t page, plat_memobj_type_t type)
 {
     errval_t err;
     plat_error_t perr = PLAT_ERR_OK;
@@ -330,6 +332,11 @@ plat_error_t plat_vm_create(const char *path, plat_memobj_t *memobj, size_t size
         return PLAT_ERR_ARGS_INVALID;
     }
 
+    /* all memory objects are frames, they are mapped with the page size of the mapping */
+    if (type != PLAT_MEMOBJ_MEMFD || page == PLAT_PAGE_THP) {
+        return PLAT_ERR_NOT_SUPPORTED;
+    }
+
     struct plat_memobj *plat_mobj = malloc(sizeof(struct plat_memobj));
     if (plat_mobj == NULL) {
         return PLAT_ERR_NO_MEM;
@@ -396,6 +403,26 @@ plat_error_t plat_vm_destroy(plat_memobj_t memobj)
 }
 
 
+/**
+ * @brief obtains the flags to map a frame
+ *
+ * @param page      the pages of the mapping
+ *
+ * @returns the vregion flags
+ */
+static vregion_flags_t plat_vm_map_flags(plat_page_t page)
+{
+    vregion_flags_t flags = VREGION_FLAGS_READ_WRITE;
+    if (page == PLAT_PAGE_HUGE_2M) {
+        flags |= VREGION_FLAGS_LARGE;
+    } else if (page == PLAT_PAGE_HUGE_1G) {
+        flags |= VREGION_FLAGS_HUGE;
+    }
+
+    return flags;
+}
+
+
 /**
  * @brief maps a region of the memory object
  *
@@ -403,11 +430,12 @@ plat_error_t plat_vm_destroy(plat_memobj_t memobj)
  * @param size      the size of the mapping to be created
  * @param memobj    the backing memory object for this mapping
  * @param offset    the offset into the memory object
- * @param huge      use a huge page mapping
+ * @param page      the pages of the mapping
  *
  * @returns returned error value
  */
-plat_error_t plat_vm_map(void **addr, size_t size, plat_memobj_t memobj, off_t offset, bool huge)
+plat_error_t plat_vm_map(void **addr, size_t size, plat_memobj_t memobj, off_t offset,
+                         plat_page_t page)
 {
     errval_t err;
 
@@ -421,10 +449,7 @@ plat_error_t plat_vm_map(void **addr, size_t size, plat_memobj_t memobj, off_t o
         return PLAT_ERR_ARGS_INVALID;
     }
 
-    vregion_flags_t flags = VREGION_FLAGS_READ_WRITE;
-    if (huge) {
-        flags |= VREGION_FLAGS_LARGE;
-    }
+    vregion_flags_t flags = plat_vm_map_flags(page);
 
     void *map_addr;
     err = vspace_map_one_frame_attr(&map_addr, size, plat_mobj->frame, flags, NULL, NULL);
@@ -497,12 +522,12 @@ static int alloc_vregion(struct vregion **retvreg, struct memobj_one_frame_one_m
  * @param size      the size of the mapping to be created
  * @param memobj    the backing memory object for this mapping
  * @param offset    the offset into the memory object
- * @param huge      use a huge page mapping
+ * @param page      the pages of the mapping
  *
  * @returns returned error value
  */
 plat_error_t plat_vm_map_fixed(void *addr, size_t size, plat_memobj_t memobj, off_t offset,
-                               bool huge)
+                               plat_page_t page)
 {
     errval_t err;
 
@@ -515,10 +540,7 @@ plat_error_t plat_vm_map_fixed(void *addr, size_t size, plat_memobj_t memobj, of
         return PLAT_ERR_ARGS_INVALID;
     }
 
-    vregion_flags_t flags = VREGION_FLAGS_READ_WRITE;
-    if (huge) {
-        flags |= VREGION_FLAGS_LARGE;
-    }
+    vregion_flags_t flags = plat_vm_map_flags(page);
 
     struct vregion *vregion;
     struct memobj_one_frame_one_map *bf_memobj;
@@ -536,6 +558,31 @@ plat_error_t plat_vm_map_fixed(void *addr, size_t size, plat_memobj_t memobj, of
 }
 
 
+/**
+ * @brief maps a region of the memory object without populating the page tables
+ *
+ * @param addr      the address to map at if not NULL, returns the address of the mapping
+ * @param size      the size of the mapping to be created
+ * @param memobj    the backing memory object for this mapping
+ * @param offset    the offset into the memory object
+ * @param page      the pages of the mapping
+ *
+ * @returns returned error value
+ */
+plat_error_t plat_vm_map_lazy(void **addr, size_t size, plat_memobj_t memobj, off_t offset,
+                              plat_page_t page)
+{
+    (void)(addr);
+    (void)(size);
+    (void)(memobj);
+    (void)(offset);
+    (void)(page);
+
+    /* frames are always mapped eagerly */
+    return PLAT_ERR_NOT_SUPPORTED;
+}
+
+
 /**
  * @brief changes the permissios of a mapping
  *
@@ -564,6 +611,47 @@ plat_error_t plat_vm_protect(void *addr, size_t size, plat_perm_t perms)
 }
 
 
+/**
+ * @brief writes the dirty pages of a mapped memory region back to the memory object
+ *
+ * @param addr      the start of the memory region
+ * @param size      the size of the memory region
+ *
+ * @returns error value
+ */
+plat_error_t plat_vm_sync(void *addr, size_t size)
+{
+    (void)(addr);
+    (void)(size);
+
+    return PLAT_ERR_NOT_SUPPORTED;
+}
+
+
+/**
+ * @brief resizes or moves a mapping
+ *
+ * @param addr      the address of the mapping
+ * @param size      the size of the mapping
+ * @param new_addr  the address to move to if not NULL, returns the new address of the mapping
+ * @param new_size  the new size of the mapping
+ * @param mode      how the mapping is changed
+ *
+ * @returns error value
+ */
+plat_error_t plat_vm_remap(void *addr, size_t size, void **new_addr, size_t new_size,
+                           plat_remap_t mode)
+{
+    (void)(addr);
+    (void)(size);
+    (void)(new_addr);
+    (void)(new_size);
+    (void)(mode);
+
+    return PLAT_ERR_NOT_SUPPORTED;
+}
+
+
 /**
  * @brief unmaps a previously mapped memory region
  *
@@ -587,6 +675,125 @@ plat_error_t plat_vm_unmap(void *addr, size_t size)
 }
 
 
+/**
+ * @brief releases the pages backing a mapped memory region
+ *
+ * @param addr      the start of the memory region
+ * @param size      the size of the memory region
+ * @param memobj    the memory object backing the region
+ *
+ * @returns error value
+ */
+plat_error_t plat_vm_discard(void *addr, size_t size, plat_memobj_t memobj)
+{
+    (void)(addr);
+    (void)(size);
+    (void)(memobj);
+
+    return PLAT_ERR_NOT_SUPPORTED;
+}
+
+
+/**
+ * @brief obtains the size of the pages the kernel backs a mapping with
+ *
+ * @param addr      an address within the mapping
+ * @param pagesize  returns the size of the largest page that backs the mapping
+ *
+ * @returns error value
+ */
+plat_error_t plat_vm_page_size(void *addr, size_t *pagesize)
+{
+    (void)(addr);
+    (void)(pagesize);
+
+    /* the page size is the one of the mapping request */
+    return PLAT_ERR_NOT_SUPPORTED;
+}
+
+
+/**
+ * @brief counts the mappings of the address space
+ *
+ * @param count     returns the number of mappings
+ *
+ * @returns error value
+ */
+plat_error_t plat_vm_count_mappings(size_t *count)
+{
+    (void)(count);
+
+    return PLAT_ERR_NOT_SUPPORTED;
+}
+
+
+/*
+ * ================================================================================================
+ * Memory Placement
+ * ================================================================================================
+ */
+
+
+/**
+ * @brief allocates page-aligned memory that is not yet backed by physical pages
+ *
+ * @param size      the size of the allocation
+ * @param ret       returns the address of the allocated memory, zero-filled on first touch
+ *
+ * @returns error value
+ */
+plat_error_t plat_mem_alloc(size_t size, void **ret)
+{
+    if (ret == NULL || size == 0) {
+        return PLAT_ERR_ARGS_INVALID;
+    }
+
+    size = (size + PLAT_ARCH_BASE_PAGE_SIZE - 1) & ~(PLAT_ARCH_BASE_PAGE_SIZE - 1);
+
+    void *addr = aligned_alloc(PLAT_ARCH_BASE_PAGE_SIZE, size);
+    if (addr == NULL) {
+        return PLAT_ERR_NO_MEM;
+    }
+    memset(addr, 0, size);
+
+    *ret = addr;
+
+    return PLAT_ERR_OK;
+}
+
+
+/**
+ * @brief places the pages of a memory region on the NUMA node of a core
+ *
+ * @param addr      the start of the memory region, rounded down to the page boundary
+ * @param size      the size of the memory region
+ * @param coreid    the core whose local node should hold the memory
+ *
+ * @returns error value
+ */
+plat_error_t plat_mem_bind_local(void *addr, size_t size, uint32_t coreid)
+{
+    (void)(addr);
+    (void)(size);
+    (void)(coreid);
+
+    return PLAT_ERR_NOT_SUPPORTED;
+}
+
+
+/**
+ * @brief frees memory allocated with plat_mem_alloc
+ *
+ * @param addr      the address of the allocated memory
+ * @param size      the size of the allocation
+ */
+void plat_mem_free(void *addr, size_t size)
+{
+    (void)(size);
+    free(addr);
+}
+
+
 /*
  * ================================================================================================
  * Threading Functions
@@ -701,6 +908,28 @@ plat_thread_t plat_thread_start(plat_thread_fn_t run, struct vmops_bench_run_arg
 }
 
 
+/**
+ * @brief creates and starts a new process that runs a function and exits
+ *
+ * @param run       function to be executed in the process
+ * @param st        state to be passed to the function
+ * @param coreid    the core to run the process on
+ *
+ * @returns handle to the process, or NULL on error
+ */
+plat_thread_t plat_process_start(plat_thread_fn_t run, struct vmops_bench_run_arg *st,
+                                 uint32_t coreid)
+{
+    (void)(run);
+    (void)(st);
+    (void)(coreid);
+
+    LOG_ERR("plat_process_start is not supported on Barrelfish\n");
+
+    return NULL;
+}
+
+
 /**
  * @brief cancels and frees up a already created thread
  *
@@ -724,8 +953,8 @@ plat_error_t plat_thread_cancel(plat_thread_t thread)
 typedef struct pthread_barrier
 {
     unsigned max;
-    volatile unsigned cycle;
-    volatile unsigned counter;
+    volatile unsigned cycle __attribute__((aligned(PLAT_ARCH_CACHELINE_SIZE)));
+    volatile unsigned counter __attribute__((aligned(PLAT_ARCH_CACHELINE_SIZE)));
 } pthread_barrier_t;
 
 
@@ -777,7 +1006,7 @@ int pthread_barrier_destroy(pthread_barrier_t *barrier)
  */
 plat_error_t plat_thread_barrier_init(plat_barrier_t *barrier, uint32_t nthreads)
 {
-    pthread_barrier_t *pbar = malloc(sizeof(pthread_barrier_t));
+    pthread_barrier_t *pbar = aligned_alloc(PLAT_ARCH_CACHELINE_SIZE, sizeof(pthread_barrier_t));
     if (pbar == NULL) {
         return PLAT_ERR_NO_MEM;
     }
@@ -910,6 +1139,136 @@ void plat_usleep(uint32_t us)
     return;
 }
 
+/*
+ * ================================================================================================
+ * Performance Counters
+ * ================================================================================================
+ */
+
+
+/**
+ * @brief opens the performance counters for the calling thread
+ *
+ * @param perfctr   returns the handle to the counter group
+ *
+ * @returns error value
+ */
+plat_error_t plat_perfctr_open(plat_perfctr_t *perfctr)
+{
+    (void)(perfctr);
+
+    return PLAT_ERR_NOT_SUPPORTED;
+}
+
+
+/**
+ * @brief reads the current values of the performance counters
+ *
+ * @param perfctr   the counter group opened by the calling thread
+ * @param values    returns the values indexed by plat_perfctr_event_t
+ *
+ * @returns error value
+ */
+plat_error_t plat_perfctr_read(plat_perfctr_t perfctr, uint64_t values[PLAT_PERFCTR_MAX])
+{
+    (void)(perfctr);
+    (void)(values);
+
+    return PLAT_ERR_NOT_SUPPORTED;
+}
+
+
+/**
+ * @brief closes the performance counters
+ *
+ * @param perfctr   the counter group to close
+ *
+ * @returns error value
+ */
+plat_error_t plat_perfctr_close(plat_perfctr_t perfctr)
+{
+    (void)(perfctr);
+
+    return PLAT_ERR_NOT_SUPPORTED;
+}
+
+
+/*
+ * ================================================================================================
+ * Interrupt Accounting
+ * ================================================================================================
+ */
+
+
+/**
+ * @brief opens the interrupt accounting of the system
+ *
+ * @param irqstats  returns the handle to the interrupt accounting
+ *
+ * @returns error value
+ */
+plat_error_t plat_irqstats_open(plat_irqstats_t *irqstats)
+{
+    (void)(irqstats);
+
+    return PLAT_ERR_NOT_SUPPORTED;
+}
+
+
+/**
+ * @brief takes a snapshot of the interrupt counts
+ *
+ * @param irqstats  the interrupt accounting handle
+ * @param counts    returns the current counts
+ *
+ * @returns error value
+ */
+plat_error_t plat_irqstats_read(plat_irqstats_t irqstats, struct plat_irqcounts *counts)
+{
+    (void)(irqstats);
+    (void)(counts);
+
+    return PLAT_ERR_NOT_SUPPORTED;
+}
+
+
+/**
+ * @brief closes the interrupt accounting
+ *
+ * @param irqstats  the interrupt accounting handle
+ *
+ * @returns error value
+ */
+plat_error_t plat_irqstats_close(plat_irqstats_t irqstats)
+{
+    (void)(irqstats);
+
+    return PLAT_ERR_NOT_SUPPORTED;
+}
+
+
+/*
+ * ================================================================================================
+ * System Environment
+ * ================================================================================================
+ */
+
+
+/**
+ * @brief reports the properties of the system environment that affect the results
+ *
+ * @param fn    the function called for each property
+ * @param st    the state passed to the function
+ *
+ * @returns error value
+ */
+plat_error_t plat_get_environment(plat_env_fn_t fn, void *st)
+{
+    fn(st, NULL, "os", "barrelfish");
+    return PLAT_ERR_OK;
+}
+
+
 /*
  * ================================================================================================
  * Logging Functions
@@ -7,6 +7,7 @@
 #define _GNU_SOURCE
 
 #include <stdio.h>
+#include <inttypes.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
@@ -16,19 +17,40 @@
 #include <sched.h>
 #include <time.h>
 #include <numa.h>
+#include <cpuid.h>
+#include <dirent.h>
 
 #include <linux/memfd.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
 #include <sys/sysinfo.h>
 #include <sys/types.h>
+#include <sys/utsname.h>
 #include <sys/mman.h>
 #include <sys/stat.h> /* For mode constants */
+#include <sys/wait.h>
+#include <signal.h>
 
 
 #include "platform.h"
 #include "../logging.h"
+#include "../benchmarks/benchmarks.h"
 
 
 #define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+
+#ifndef MREMAP_DONTUNMAP
+#define MREMAP_DONTUNMAP 4
+#endif
+
+#ifndef MADV_POPULATE_READ
+#define MADV_POPULATE_READ 22
+#define MADV_POPULATE_WRITE 23
+#endif
+
+static void plat_timer_init(plat_timer_t timer);
 
 /*
  * ================================================================================================
@@ -46,11 +68,12 @@
  */
 plat_error_t plat_init(struct vmops_bench_cfg *cfg)
 {
-    (void)cfg;
     LOG_PRINT("Initializing VMOPS bench on Linux\n");
-    LOG_INFO("hint: reserve hugepages '/sys/kernel/mm/hugepages/hugepages-2048kB/nr_hugepages'\n");
+    LOG_INFO("hint: reserve hugepages '/sys/kernel/mm/hugepages/hugepages-*kB/nr_hugepages'\n");
     LOG_INFO("hint: allow more mappings 'sysctl -w vm.max_map_count=2000000000'\n");
 
+    plat_timer_init(cfg->timer);
+
     return PLAT_ERR_OK;
 }
 
@@ -190,8 +213,9 @@ err_out_1:
 ///< holds the information about a memory object
 struct plat_memobj {
     size_t size;
-    int fd;       ///< the file descriptor
-    char name[];  ///< the name of the memory object
+    plat_memobj_type_t type;  ///< the backend of the memory object
+    int fd;                   ///< the file descriptor, -1 for anonymous memory
+    char name[];              ///< the name of the memory object
 };
 
 
@@ -201,11 +225,13 @@ struct plat_memobj {
  * @param path      the name/path of the memobj
  * @param memobj    returns a pointer to the created memory object
  * @param size      the maximum size for the memory object
- * @param huge      use huge pages for this memory object
+ * @param page      the pages of the memory object
+ * @param type      the backend of the memory object
  *
  * @returns error value
  */
-plat_error_t plat_vm_create(const char *path, plat_memobj_t *memobj, size_t size, bool huge)
+plat_error_t plat_vm_create(const char *path, plat_memobj_t *memobj, size_t size,
+                            plat_page_t page, plat_memobj_type_t type)
 {
     plat_error_t err = PLAT_ERR_OK;
 
@@ -213,33 +239,80 @@ plat_error_t plat_vm_create(const char *path, plat_memobj_t *memobj, size_t size
         return PLAT_ERR_ARGS_INVALID;
     }
 
+    /* only memfds and anonymous memory can be backed by the huge page pool */
+    bool hugetlb = page == PLAT_PAGE_HUGE_2M || page == PLAT_PAGE_HUGE_1G;
+    if (hugetlb && type != PLAT_MEMOBJ_MEMFD && type != PLAT_MEMOBJ_ANON_PRIVATE
+        && type != PLAT_MEMOBJ_ANON_SHARED) {
+        LOG_ERR("%s objects do not support huge pages\n",
+                type == PLAT_MEMOBJ_SHM ? "shm" : "file");
+        return PLAT_ERR_NOT_SUPPORTED;
+    }
+
     struct plat_memobj *plat_mobj = malloc(sizeof(struct plat_memobj) + strlen(path) + 1);
     if (plat_mobj == NULL) {
         return PLAT_ERR_NO_MEM;
     }
 
-    int flags = 0;
-    if (huge) {
-        flags |= MFD_HUGETLB | MFD_HUGE_2MB;
+    int fd = -1;
+    switch (type) {
+    case PLAT_MEMOBJ_MEMFD:
+        if (page == PLAT_PAGE_HUGE_2M) {
+            fd = memfd_create(path, MFD_HUGETLB | MFD_HUGE_2MB);
+        } else if (page == PLAT_PAGE_HUGE_1G) {
+            fd = memfd_create(path, MFD_HUGETLB | MFD_HUGE_1GB);
+        } else {
+            fd = memfd_create(path, 0);
+        }
+        break;
+    case PLAT_MEMOBJ_SHM:
+        /* unlinked right away like the files, such that no shm file is left behind */
+        fd = shm_open(path, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+        if (fd != -1) {
+            shm_unlink(path);
+        }
+        break;
+    case PLAT_MEMOBJ_FILE:
+    case PLAT_MEMOBJ_FILE_PREALLOC:
+        /* the file is unlinked right away, it is removed once the last mapping is gone */
+        fd = open(path, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+        if (fd != -1) {
+            unlink(path);
+        }
+        break;
+    case PLAT_MEMOBJ_ANON_PRIVATE:
+    case PLAT_MEMOBJ_ANON_SHARED:
+        /* anonymous memory is created by each mapping */
+        break;
+    default:
+        err = PLAT_ERR_ARGS_INVALID;
+        goto err_out_1;
     }
 
-    int fd = -1;
-    fd = memfd_create(path, flags);
-    if (fd == -1) {
+    if (fd == -1 && type != PLAT_MEMOBJ_ANON_PRIVATE && type != PLAT_MEMOBJ_ANON_SHARED) {
         if (errno == EEXIST) {
             LOG_ERR("shm file '%s' already exist. delete it in /dev/shm\n", path);
+        } else {
+            LOG_ERR("could not create '%s': %s\n", path, strerror(errno));
         }
         err = PLAT_ERR_MEMOBJ_CREATE;
         goto err_out_1;
     }
 
     /* truncate the file to a given size */
-    if (ftruncate(fd, size) != 0) {
+    if (fd != -1 && ftruncate(fd, size) != 0) {
+        err = PLAT_ERR_NO_MEM;
+        goto err_out_2;
+    }
+
+    /* allocate the blocks of the file, otherwise it stays sparse */
+    if (type == PLAT_MEMOBJ_FILE_PREALLOC && posix_fallocate(fd, 0, size) != 0) {
+        LOG_ERR("could not preallocate '%s'\n", path);
         err = PLAT_ERR_NO_MEM;
         goto err_out_2;
     }
 
     strcpy(plat_mobj->name, path);
+    plat_mobj->type = type;
     plat_mobj->fd = fd;
     plat_mobj->size = size;
 
@@ -248,7 +321,7 @@ plat_error_t plat_vm_create(const char *path, plat_memobj_t *memobj, size_t size
     return PLAT_ERR_OK;
 
 err_out_2:
-    shm_unlink(path);
+    close(fd);
 
 err_out_1:
     free(plat_mobj);
@@ -268,11 +341,10 @@ plat_error_t plat_vm_destroy(plat_memobj_t memobj)
 {
     struct plat_memobj *plat_mobj = (struct plat_memobj *)memobj;
 
-    if (plat_mobj->fd != 0) {
-        // if (shm_unlink(plat_mobj->name)) {
-        //     LOG_WARN("could not unline '%s'. Continuing anyway.\n", plat_mobj->name);
-        // }
+    if (plat_mobj->fd != -1) {
+        close(plat_mobj->fd);
     }
+
     memset(plat_mobj, 0, sizeof(struct plat_memobj));
     free(plat_mobj);
 
@@ -280,6 +352,143 @@ plat_error_t plat_vm_destroy(plat_memobj_t memobj)
 }
 
 
+/**
+ * @brief obtains the flags to map a memory object
+ *
+ * @param plat_mobj the memory object to be mapped
+ * @param page      the pages of the mapping
+ *
+ * @returns the mmap flags
+ */
+static int plat_vm_map_flags(struct plat_memobj *plat_mobj, plat_page_t page)
+{
+    int flags = plat_mobj->type == PLAT_MEMOBJ_ANON_PRIVATE ? MAP_PRIVATE : MAP_SHARED;
+    if (plat_mobj->fd == -1) {
+        flags |= MAP_ANONYMOUS;
+    }
+
+    if (page == PLAT_PAGE_HUGE_2M) {
+        flags |= MAP_HUGETLB | MAP_HUGE_2MB;
+    } else if (page == PLAT_PAGE_HUGE_1G) {
+        flags |= MAP_HUGETLB | MAP_HUGE_1GB;
+    }
+
+    return flags;
+}
+
+
+/**
+ * @brief maps a memory object at an address aligned to the huge page size
+ *
+ * @param size      the size of the mapping
+ * @param flags     the mmap flags
+ * @param fd        the file descriptor of the memory object
+ * @param offset    the offset into the memory object
+ *
+ * @returns the address of the mapping, MAP_FAILED on failure
+ */
+static void *plat_vm_mmap_aligned(size_t size, int flags, int fd, off_t offset)
+{
+    /* most kernels already align large mappings, only fall back to a reservation if not */
+    void *map_addr = mmap(NULL, size, PROT_READ | PROT_WRITE, flags, fd, offset);
+    if (map_addr == MAP_FAILED || ((uintptr_t)map_addr & (PLAT_ARCH_HUGE_PAGE_SIZE - 1)) == 0) {
+        return map_addr;
+    }
+
+    munmap(map_addr, size);
+
+    /* reserve enough space to place the mapping at the next huge page boundary in it */
+    size_t resv_size = size + PLAT_ARCH_HUGE_PAGE_SIZE;
+    void *resv = mmap(NULL, resv_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                      -1, 0);
+    if (resv == MAP_FAILED) {
+        return MAP_FAILED;
+    }
+
+    uintptr_t start = (uintptr_t)resv;
+    uintptr_t aligned = (start + PLAT_ARCH_HUGE_PAGE_SIZE - 1) & ~(PLAT_ARCH_HUGE_PAGE_SIZE - 1UL);
+
+    map_addr = mmap((void *)aligned, size, PROT_READ | PROT_WRITE, flags | MAP_FIXED, fd, offset);
+    if (map_addr == MAP_FAILED) {
+        munmap(resv, resv_size);
+        return MAP_FAILED;
+    }
+
+    /* release the parts of the reservation around the mapping */
+    if (aligned != start) {
+        munmap(resv, aligned - start);
+    }
+    if (start + resv_size != aligned + size) {
+        munmap((void *)(aligned + size), start + resv_size - (aligned + size));
+    }
+
+    return map_addr;
+}
+
+
+/**
+ * @brief maps a memory object with the given pages
+ *
+ * @param addr      the address to map at if not NULL
+ * @param size      the size of the mapping
+ * @param plat_mobj the memory object to be mapped
+ * @param offset    the offset into the memory object
+ * @param page      the pages of the mapping
+ * @param populate  populate the page tables of the mapping
+ *
+ * @returns the address of the mapping, MAP_FAILED on failure
+ *
+ * Mappings with transparent huge pages are advised to use them before they are populated.
+ */
+static void *plat_vm_mmap(void *addr, size_t size, struct plat_memobj *plat_mobj, off_t offset,
+                          plat_page_t page, bool populate)
+{
+    int flags = plat_vm_map_flags(plat_mobj, page);
+    if (addr != NULL) {
+        flags |= MAP_FIXED;
+    }
+
+    if (plat_mobj->fd == -1) {
+        offset = 0;
+    }
+
+    if (page != PLAT_PAGE_THP) {
+        if (populate) {
+            flags |= MAP_POPULATE;
+        }
+        return mmap(addr, size, PROT_READ | PROT_WRITE, flags, plat_mobj->fd, offset);
+    }
+
+    void *map_addr;
+    if (addr == NULL) {
+        map_addr = plat_vm_mmap_aligned(size, flags, plat_mobj->fd, offset);
+    } else {
+        map_addr = mmap(addr, size, PROT_READ | PROT_WRITE, flags, plat_mobj->fd, offset);
+    }
+
+    if (map_addr == MAP_FAILED) {
+        return MAP_FAILED;
+    }
+
+    if (madvise(map_addr, size, MADV_HUGEPAGE)) {
+        LOG_ERR("could not advise transparent huge pages: %s\n", strerror(errno));
+        munmap(map_addr, size);
+        return MAP_FAILED;
+    }
+
+    /* populate the mapping like MAP_POPULATE, which writes only private mappings */
+    int advice = plat_mobj->type == PLAT_MEMOBJ_ANON_PRIVATE ? MADV_POPULATE_WRITE
+                                                              : MADV_POPULATE_READ;
+    if (populate && madvise(map_addr, size, advice)) {
+        LOG_ERR("could not populate the mapping: %s\n", strerror(errno));
+        munmap(map_addr, size);
+        return MAP_FAILED;
+    }
+
+    return map_addr;
+}
+
+
 /**
  * @brief maps a region of the memory object
  *
@@ -287,14 +496,15 @@ plat_error_t plat_vm_destroy(plat_memobj_t memobj)
  * @param size      the size of the mapping to be created
  * @param memobj    the backing memory object for this mapping
  * @param offset    the offset into the memory object
- * @param huge      use a huge page mapping
+ * @param page      the pages of the mapping
  *
  * @returns returned error value
  */
-plat_error_t plat_vm_map(void **addr, size_t size, plat_memobj_t memobj, off_t offset, bool huge)
+plat_error_t plat_vm_map(void **addr, size_t size, plat_memobj_t memobj, off_t offset,
+                         plat_page_t page)
 {
     struct plat_memobj *plat_mobj = (struct plat_memobj *)memobj;
-    if (plat_mobj->fd == 0 || plat_mobj->size < offset + size) {
+    if (plat_mobj == NULL || plat_mobj->size < offset + size) {
         return PLAT_ERR_ARGS_INVALID;
     }
 
@@ -302,14 +512,8 @@ plat_error_t plat_vm_map(void **addr, size_t size, plat_memobj_t memobj, off_t o
         return PLAT_ERR_ARGS_INVALID;
     }
 
-    int flags = MAP_SHARED | MAP_POPULATE;
-
-    if (huge) {
-        flags |= MAP_HUGETLB | MAP_HUGE_2MB;
-    }
-
     void *map_addr;
-    map_addr = mmap(NULL, size, PROT_READ | PROT_WRITE, flags, plat_mobj->fd, offset);
+    map_addr = plat_vm_mmap(NULL, size, plat_mobj, offset, page, true);
     if (map_addr == MAP_FAILED) {
         return PLAT_ERR_MAP_FAILED;
     }
@@ -327,15 +531,15 @@ plat_error_t plat_vm_map(void **addr, size_t size, plat_memobj_t memobj, off_t o
  * @param size      the size of the mapping to be created
  * @param memobj    the backing memory object for this mapping
  * @param offset    the offset into the memory object
- * @param huge      use a huge page mapping
+ * @param page      the pages of the mapping
  *
  * @returns returned error value
  */
 plat_error_t plat_vm_map_fixed(void *addr, size_t size, plat_memobj_t memobj, off_t offset,
-                               bool huge)
+                               plat_page_t page)
 {
     struct plat_memobj *plat_mobj = (struct plat_memobj *)memobj;
-    if (plat_mobj->fd == 0 || plat_mobj->size < offset + size) {
+    if (plat_mobj == NULL || plat_mobj->size < offset + size) {
         return PLAT_ERR_ARGS_INVALID;
     }
 
@@ -343,23 +547,56 @@ plat_error_t plat_vm_map_fixed(void *addr, size_t size, plat_memobj_t memobj, of
         return PLAT_ERR_ARGS_INVALID;
     }
 
-    int flags = MAP_SHARED | MAP_POPULATE | MAP_FIXED;
+    void *map_addr;
+    map_addr = plat_vm_mmap(addr, size, plat_mobj, offset, page, true);
+    if (map_addr == MAP_FAILED) {
+        LOG_ERR("Error = (%d) %s \n", errno, strerror(errno));
+        return PLAT_ERR_MAP_FAILED;
+    }
 
-    if (huge) {
-        flags |= MAP_HUGETLB | MAP_HUGE_2MB;
+    if (map_addr != addr) {
+        return PLAT_ERR_MAP_FAILED;
+    }
+
+    return PLAT_ERR_OK;
+}
+
+
+/**
+ * @brief maps a region of the memory object without populating the page tables
+ *
+ * @param addr      the address to map at if not NULL, returns the address of the mapping
+ * @param size      the size of the mapping to be created
+ * @param memobj    the backing memory object for this mapping
+ * @param offset    the offset into the memory object
+ * @param page      the pages of the mapping
+ *
+ * @returns returned error value
+ */
+plat_error_t plat_vm_map_lazy(void **addr, size_t size, plat_memobj_t memobj, off_t offset,
+                              plat_page_t page)
+{
+    struct plat_memobj *plat_mobj = (struct plat_memobj *)memobj;
+    if (plat_mobj == NULL || plat_mobj->size < offset + size) {
+        return PLAT_ERR_ARGS_INVALID;
+    }
+
+    if (addr == NULL) {
+        return PLAT_ERR_ARGS_INVALID;
     }
 
     void *map_addr;
-    map_addr = mmap(addr, size, PROT_READ | PROT_WRITE, flags, plat_mobj->fd, offset);
+    map_addr = plat_vm_mmap(*addr, size, plat_mobj, offset, page, false);
     if (map_addr == MAP_FAILED) {
-        LOG_ERR("Error = (%d) %s \n", errno, strerror(errno));
         return PLAT_ERR_MAP_FAILED;
     }
 
-    if (map_addr != addr) {
+    if (*addr != NULL && map_addr != *addr) {
         return PLAT_ERR_MAP_FAILED;
     }
 
+    *addr = map_addr;
+
     return PLAT_ERR_OK;
 }
 
@@ -389,159 +626,502 @@ plat_error_t plat_vm_protect(void *addr, size_t size, plat_perm_t perms)
 
 
 /**
- * @brief unmaps a previously mapped memory region
+ * @brief writes the dirty pages of a mapped memory region back to the memory object
  *
- * @param addr      the address to be unmapped
- * @param size      the size of the region to be unmapped
+ * @param addr      the start of the memory region
+ * @param size      the size of the memory region
  *
  * @returns error value
  */
-plat_error_t plat_vm_unmap(void *addr, size_t size)
+plat_error_t plat_vm_sync(void *addr, size_t size)
 {
-    if (munmap(addr, size)) {
-        return PLAT_ERR_UNMAP_FAILED;
+    if (msync(addr, size, MS_SYNC)) {
+        return PLAT_ERR_SYNC_FAILED;
     }
     return PLAT_ERR_OK;
 }
 
 
-/*
- * ================================================================================================
- * Threading Functions
- * ================================================================================================
+/**
+ * @brief resizes or moves a mapping
+ *
+ * @param addr      the address of the mapping
+ * @param size      the size of the mapping
+ * @param new_addr  the address to move to if not NULL, returns the new address of the mapping
+ * @param new_size  the new size of the mapping
+ * @param mode      how the mapping is changed
+ *
+ * @returns error value
  */
+plat_error_t plat_vm_remap(void *addr, size_t size, void **new_addr, size_t new_size,
+                           plat_remap_t mode)
+{
+    if (new_addr == NULL) {
+        return PLAT_ERR_ARGS_INVALID;
+    }
 
+    int flags = 0;
+    switch (mode) {
+    case PLAT_REMAP_RESIZE:
+        break;
+    case PLAT_REMAP_MOVE:
+        flags = MREMAP_MAYMOVE;
+        break;
+    case PLAT_REMAP_DONTUNMAP:
+        if (size != new_size) {
+            return PLAT_ERR_ARGS_INVALID;
+        }
+        flags = MREMAP_MAYMOVE | MREMAP_DONTUNMAP;
+        break;
+    }
 
-struct plat_thread {
-    pthread_t thread;
-    uint32_t coreid;
-    cpu_set_t cpuset;
-    plat_thread_fn_t run;
-    struct vmops_bench_run_arg *st;
-};
-
+    if (mode != PLAT_REMAP_RESIZE && *new_addr != NULL) {
+        flags |= MREMAP_FIXED;
+    }
 
-static void *plat_thread_run_fn(void *st)
-{
-    struct plat_thread *thr = (struct plat_thread *)st;
+    void *map_addr = mremap(addr, size, new_size, flags, *new_addr);
+    if (map_addr == MAP_FAILED) {
+        return PLAT_ERR_MAP_FAILED;
+    }
 
-    CPU_ZERO(&thr->cpuset);
-    CPU_SET(thr->coreid, &thr->cpuset);
-    pthread_setaffinity_np(pthread_self(), sizeof(thr->cpuset), &thr->cpuset);
+    *new_addr = map_addr;
 
-    thr->run(thr->st);
-    return NULL;
+    return PLAT_ERR_OK;
 }
 
 
 /**
- * @brief creates and starts a new thread
+ * @brief unmaps a previously mapped memory region
  *
- * @param run       function to be executed on the thread
- * @param st        state to be passed to the function
- * @param coreid    the core to run the thread on
+ * @param addr      the address to be unmapped
+ * @param size      the size of the region to be unmapped
  *
- * @returns handle to the thread, or NULL on error
+ * @returns error value
  */
-plat_thread_t plat_thread_start(plat_thread_fn_t run, struct vmops_bench_run_arg *st,
-                                uint32_t coreid)
+plat_error_t plat_vm_unmap(void *addr, size_t size)
 {
-    struct plat_thread *thread = malloc(sizeof(struct plat_thread));
-    if (thread == NULL) {
-        return NULL;
+    if (munmap(addr, size)) {
+        return PLAT_ERR_UNMAP_FAILED;
     }
+    return PLAT_ERR_OK;
+}
 
-    thread->coreid = coreid;
-    thread->run = run;
-    thread->st = st;
 
-    if (pthread_create(&thread->thread, NULL, plat_thread_run_fn, thread)) {
-        free(thread);
-        return 0;
-    }
+/**
+ * @brief releases the pages backing a mapped memory region
+ *
+ * @param addr      the start of the memory region
+ * @param size      the size of the memory region
+ * @param memobj    the memory object backing the region
+ *
+ * @returns error value
+ */
+plat_error_t plat_vm_discard(void *addr, size_t size, plat_memobj_t memobj)
+{
+    struct plat_memobj *plat_mobj = (struct plat_memobj *)memobj;
 
-    return (plat_thread_t)thread;
+    /* shared pages are freed in the memory object, MADV_DONTNEED would only unmap them */
+    int advice = plat_mobj->type == PLAT_MEMOBJ_ANON_PRIVATE ? MADV_DONTNEED : MADV_REMOVE;
+    if (madvise(addr, size, advice)) {
+        return PLAT_ERR_UNMAP_FAILED;
+    }
+    return PLAT_ERR_OK;
 }
 
 
 /**
- * @brief cancels and frees up a already created thread
+ * @brief obtains the size of the pages the kernel backs a mapping with
  *
- * @param thread    the thread to be cancelled
+ * @param addr      an address within the mapping
+ * @param pagesize  returns the size of the largest page that backs the mapping
  *
  * @returns error value
  */
-plat_error_t plat_thread_cancel(plat_thread_t thread)
+plat_error_t plat_vm_page_size(void *addr, size_t *pagesize)
 {
-    struct plat_thread *platthread = (struct plat_thread *)thread;
+    if (pagesize == NULL) {
+        return PLAT_ERR_ARGS_INVALID;
+    }
+
+    FILE *f = fopen("/proc/self/smaps", "r");
+    if (f == NULL) {
+        return PLAT_ERR_FILE_OPEN;
+    }
+
+    /* each mapping starts with a line of its address range, followed by its properties */
+    bool found = false;
+    size_t size = 0;
+    char line[512];
+    while (fgets(line, sizeof(line), f) != NULL) {
+        uintptr_t start, end;
+        size_t kb;
+        if (sscanf(line, "%" SCNxPTR "-%" SCNxPTR " ", &start, &end) == 2) {
+            if (found) {
+                break;
+            }
+            found = start <= (uintptr_t)addr && (uintptr_t)addr < end;
+        } else if (!found) {
+            continue;
+        } else if (sscanf(line, "KernelPageSize: %zu kB", &kb) == 1) {
+            size = (kb << 10) > size ? (kb << 10) : size;
+        } else if (sscanf(line, "AnonHugePages: %zu kB", &kb) == 1
+                   || sscanf(line, "ShmemPmdMapped: %zu kB", &kb) == 1
+                   || sscanf(line, "FilePmdMapped: %zu kB", &kb) == 1) {
+            /* parts of the mapping are backed by transparent huge pages */
+            if (kb > 0 && size < PLAT_ARCH_HUGE_PAGE_SIZE) {
+                size = PLAT_ARCH_HUGE_PAGE_SIZE;
+            }
+        }
+    }
 
+    fclose(f);
 
-    pthread_cancel(platthread->thread);
+    if (!found || size == 0) {
+        return PLAT_ERR_ARGS_INVALID;
+    }
 
-    memset(platthread, 0, sizeof(*platthread));
-    free(platthread);
+    *pagesize = size;
 
     return PLAT_ERR_OK;
 }
 
+
 /**
- * @brief initializes a platform barrier
+ * @brief counts the mappings of the address space
  *
- * @param barrier   the barrier to initialize
- * @param nthreads  the number of threads to expect
+ * @param count     returns the number of mappings
  *
  * @returns error value
  */
-plat_error_t plat_thread_barrier_init(plat_barrier_t *barrier, uint32_t nthreads)
+plat_error_t plat_vm_count_mappings(size_t *count)
 {
-    pthread_barrier_t *pbar = malloc(sizeof(pthread_barrier_t));
-    if (pbar == NULL) {
-        return PLAT_ERR_NO_MEM;
+    if (count == NULL) {
+        return PLAT_ERR_ARGS_INVALID;
     }
 
-    if (pthread_barrier_init(pbar, NULL, nthreads)) {
-        free(pbar);
-        return PLAT_ERR_BARRIER;
+    FILE *f = fopen("/proc/self/maps", "r");
+    if (f == NULL) {
+        return PLAT_ERR_FILE_OPEN;
+    }
+
+    /* every vma of the address space is a line of the maps file */
+    size_t lines = 0;
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            lines += buf[i] == '\n';
+        }
     }
 
-    *barrier = (plat_barrier_t)pbar;
+    fclose(f);
+
+    *count = lines;
 
     return PLAT_ERR_OK;
 }
 
 
+/*
+ * ================================================================================================
+ * Memory Placement
+ * ================================================================================================
+ */
+
+
 /**
- * @brief destroys an initalized platform barrier
+ * @brief allocates page-aligned memory that is not yet backed by physical pages
  *
- * @param barrier   the barrier to be destroyed
+ * @param size      the size of the allocation
+ * @param ret       returns the address of the allocated memory, zero-filled on first touch
  *
  * @returns error value
+ *
+ * The memory is mapped shared, so processes started afterwards see the same pages.
  */
-plat_error_t plat_thread_barrier_destroy(plat_barrier_t barrier)
+plat_error_t plat_mem_alloc(size_t size, void **ret)
 {
-    pthread_barrier_t *pbar = (pthread_barrier_t *)barrier;
-    if (pthread_barrier_destroy(pbar)) {
-        return PLAT_ERR_BARRIER;
+    if (ret == NULL || size == 0) {
+        return PLAT_ERR_ARGS_INVALID;
+    }
+
+    void *addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED) {
+        return PLAT_ERR_NO_MEM;
     }
 
+    *ret = addr;
+
     return PLAT_ERR_OK;
 }
 
 
 /**
- * @brief calls a barrier to ensure synchronization among the threads
+ * @brief places the pages of a memory region on the NUMA node of a core
  *
- * @param barrier   the barrier to enter
+ * @param addr      the start of the memory region, rounded down to the page boundary
+ * @param size      the size of the memory region
+ * @param coreid    the core whose local node should hold the memory
  *
  * @returns error value
  */
-plat_error_t plat_thread_barrier(plat_barrier_t barrier)
+plat_error_t plat_mem_bind_local(void *addr, size_t size, uint32_t coreid)
 {
-    pthread_barrier_t *pbar = (pthread_barrier_t *)barrier;
-    if (pthread_barrier_wait(pbar)) {
+    if (numa_available() == -1) {
+        return PLAT_ERR_NOT_SUPPORTED;
+    }
+
+    int node = numa_node_of_cpu(coreid);
+    if (node < 0) {
+        return PLAT_ERR_ARGS_INVALID;
+    }
+
+    uintptr_t start = (uintptr_t)addr & ~(PLAT_ARCH_BASE_PAGE_SIZE - 1);
+    uintptr_t end = (uintptr_t)addr + size;
+
+    /* numa_tonode_memory only sets the policy, the pages are allocated on first touch */
+    numa_tonode_memory((void *)start, end - start, node);
+
+    return PLAT_ERR_OK;
+}
+
+
+/**
+ * @brief frees memory allocated with plat_mem_alloc
+ *
+ * @param addr      the address of the allocated memory
+ * @param size      the size of the allocation
+ */
+void plat_mem_free(void *addr, size_t size)
+{
+    if (addr != NULL) {
+        munmap(addr, size);
+    }
+}
+
+
+/*
+ * ================================================================================================
+ * Threading Functions
+ * ================================================================================================
+ */
+
+
+struct plat_thread {
+    pthread_t thread;
+    pid_t pid;
+    uint32_t coreid;
+    cpu_set_t cpuset;
+    plat_thread_fn_t run;
+    struct vmops_bench_run_arg *st;
+};
+
+
+static void *plat_thread_run_fn(void *st)
+{
+    struct plat_thread *thr = (struct plat_thread *)st;
+
+    CPU_ZERO(&thr->cpuset);
+    CPU_SET(thr->coreid, &thr->cpuset);
+    pthread_setaffinity_np(pthread_self(), sizeof(thr->cpuset), &thr->cpuset);
+
+    thr->run(thr->st);
+    return NULL;
+}
+
+
+/**
+ * @brief creates and starts a new thread
+ *
+ * @param run       function to be executed on the thread
+ * @param st        state to be passed to the function
+ * @param coreid    the core to run the thread on
+ *
+ * @returns handle to the thread, or NULL on error
+ */
+plat_thread_t plat_thread_start(plat_thread_fn_t run, struct vmops_bench_run_arg *st,
+                                uint32_t coreid)
+{
+    struct plat_thread *thread = malloc(sizeof(struct plat_thread));
+    if (thread == NULL) {
+        return NULL;
+    }
+
+    thread->pid = 0;
+    thread->coreid = coreid;
+    thread->run = run;
+    thread->st = st;
+
+    if (pthread_create(&thread->thread, NULL, plat_thread_run_fn, thread)) {
+        free(thread);
+        return 0;
+    }
+
+    return (plat_thread_t)thread;
+}
+
+
+/**
+ * @brief creates and starts a new process that runs a function and exits
+ *
+ * @param run       function to be executed in the process
+ * @param st        state to be passed to the function
+ * @param coreid    the core to run the process on
+ *
+ * @returns handle to the process, or NULL on error
+ *
+ * The process inherits the memory objects of the caller. Results are only visible to the
+ * caller if they are written to memory allocated with plat_mem_alloc.
+ */
+plat_thread_t plat_process_start(plat_thread_fn_t run, struct vmops_bench_run_arg *st,
+                                 uint32_t coreid)
+{
+    struct plat_thread *thread = malloc(sizeof(struct plat_thread));
+    if (thread == NULL) {
+        return NULL;
+    }
+
+    thread->coreid = coreid;
+    thread->run = run;
+    thread->st = st;
+
+    /* buffered output would otherwise be written by the parent and the child */
+    fflush(NULL);
+
+    thread->pid = fork();
+    if (thread->pid == -1) {
+        free(thread);
+        return NULL;
+    }
+
+    if (thread->pid == 0) {
+        CPU_ZERO(&thread->cpuset);
+        CPU_SET(thread->coreid, &thread->cpuset);
+        sched_setaffinity(0, sizeof(thread->cpuset), &thread->cpuset);
+
+        thread->run(thread->st);
+
+        fflush(NULL);
+        _exit(EXIT_SUCCESS);
+    }
+
+    return (plat_thread_t)thread;
+}
+
+
+/**
+ * @brief cancels and frees up a already created thread
+ *
+ * @param thread    the thread to be cancelled
+ *
+ * @returns error value
+ */
+plat_error_t plat_thread_cancel(plat_thread_t thread)
+{
+    struct plat_thread *platthread = (struct plat_thread *)thread;
+
+    if (platthread->pid != 0) {
+        kill(platthread->pid, SIGKILL);
+        waitpid(platthread->pid, NULL, 0);
+    } else {
+        pthread_cancel(platthread->thread);
+    }
+
+    memset(platthread, 0, sizeof(*platthread));
+    free(platthread);
+
+    return PLAT_ERR_OK;
+}
+
+///< sense-reversing spin barrier, the arrival counter and the sense are on their own cache lines
+struct plat_barrier
+{
+    uint32_t nthreads;
+    uint32_t count __attribute__((aligned(PLAT_ARCH_CACHELINE_SIZE)));
+    uint32_t sense __attribute__((aligned(PLAT_ARCH_CACHELINE_SIZE)));
+};
+
+///< the number of spins after which a waiting thread yields its core
+#define PLAT_BARRIER_SPINS_YIELD 0x400
+
+
+/**
+ * @brief initializes a platform barrier
+ *
+ * @param barrier   the barrier to initialize
+ * @param nthreads  the number of threads to expect
+ *
+ * @returns error value
+ */
+plat_error_t plat_thread_barrier_init(plat_barrier_t *barrier, uint32_t nthreads)
+{
+    if (nthreads == 0) {
+        return PLAT_ERR_BARRIER;
+    }
+
+    /* the barrier lives in shared memory so that it also synchronizes processes */
+    struct plat_barrier *bar;
+    if (plat_mem_alloc(sizeof(struct plat_barrier), (void **)&bar) != PLAT_ERR_OK) {
+        return PLAT_ERR_NO_MEM;
+    }
+
+    bar->nthreads = nthreads;
+
+    *barrier = (plat_barrier_t)bar;
+
+    return PLAT_ERR_OK;
+}
+
+
+/**
+ * @brief destroys an initalized platform barrier
+ *
+ * @param barrier   the barrier to be destroyed
+ *
+ * @returns error value
+ */
+plat_error_t plat_thread_barrier_destroy(plat_barrier_t barrier)
+{
+    struct plat_barrier *bar = (struct plat_barrier *)barrier;
+    if (bar == NULL || __atomic_load_n(&bar->count, __ATOMIC_ACQUIRE) != 0) {
         return PLAT_ERR_BARRIER;
     }
 
+    plat_mem_free(bar, sizeof(struct plat_barrier));
+
+    return PLAT_ERR_OK;
+}
+
+
+/**
+ * @brief calls a barrier to ensure synchronization among the threads
+ *
+ * @param barrier   the barrier to enter
+ *
+ * @returns error value
+ */
+plat_error_t plat_thread_barrier(plat_barrier_t barrier)
+{
+    struct plat_barrier *bar = (struct plat_barrier *)barrier;
+
+    /* the sense only flips once all threads have arrived, so it is read before arriving */
+    uint32_t sense = __atomic_load_n(&bar->sense, __ATOMIC_ACQUIRE);
+    if (__atomic_add_fetch(&bar->count, 1, __ATOMIC_ACQ_REL) == bar->nthreads) {
+        __atomic_store_n(&bar->count, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&bar->sense, !sense, __ATOMIC_RELEASE);
+        return PLAT_ERR_OK;
+    }
+
+    uint32_t spins = 0;
+    while (__atomic_load_n(&bar->sense, __ATOMIC_ACQUIRE) == sense) {
+        if (++spins == PLAT_BARRIER_SPINS_YIELD) {
+            spins = 0;
+            sched_yield();
+        } else {
+            __builtin_ia32_pause();
+        }
+    }
+
     return PLAT_ERR_OK;
 }
 
@@ -556,8 +1136,18 @@ plat_error_t plat_thread_barrier(plat_barrier_t barrier)
 plat_error_t plat_thread_join(plat_thread_t other)
 {
     struct plat_thread *platthread = (struct plat_thread *)other;
-    void *retval;
-    pthread_join(platthread->thread, &retval);
+
+    if (platthread->pid != 0) {
+        int status;
+        if (waitpid(platthread->pid, &status, 0) == -1 || !WIFEXITED(status)
+            || WEXITSTATUS(status) != EXIT_SUCCESS) {
+            LOG_WARN("process %d on core %u did not exit cleanly\n", platthread->pid,
+                     platthread->coreid);
+        }
+    } else {
+        void *retval;
+        pthread_join(platthread->thread, &retval);
+    }
 
     memset(platthread, 0, sizeof(*platthread));
     free(platthread);
@@ -573,6 +1163,16 @@ plat_error_t plat_thread_join(plat_thread_t other)
  */
 
 
+///< the time source selected by plat_init
+static plat_timer_t plat_timer = PLAT_TIMER_MONOTONIC;
+
+///< the number of plat_time_t ticks per millisecond of the selected time source
+static uint64_t plat_ticks_per_ms = 1000000UL;
+
+///< the duration of the TSC calibration period
+#define TSC_CALIBRATION_MS 100
+
+
 static inline uint64_t rdtsc(void)
 {
     uint32_t eax, edx;
@@ -587,6 +1187,76 @@ static inline uint64_t rdtscp(void)
     return ((uint64_t)edx << 32) | eax;
 }
 
+static inline uint64_t rdtscp_fenced(void)
+{
+    /* rdtscp waits for all previous instructions, the lfence keeps later ones from starting */
+    uint64_t tsc = rdtscp();
+    __asm volatile("lfence" ::: "memory");
+    return tsc;
+}
+
+static inline uint64_t monotonic_ns(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &t);
+    return (uint64_t)(t.tv_sec * 1000000000UL + t.tv_nsec);
+}
+
+
+static bool tsc_is_invariant(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if (__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) == 0 || eax < 0x80000007) {
+        return false;
+    }
+
+    /* CPUID.80000007H:EDX[8] indicates an invariant TSC */
+    __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+    return (edx & (1 << 8)) != 0;
+}
+
+
+static uint64_t tsc_calibrate(void)
+{
+    uint64_t tsc_start = rdtscp_fenced();
+    uint64_t ns_start = monotonic_ns();
+
+    usleep(TSC_CALIBRATION_MS * 1000);
+
+    uint64_t tsc_end = rdtscp_fenced();
+    uint64_t ns_end = monotonic_ns();
+
+    return (uint64_t)((double)(tsc_end - tsc_start) * 1000000.0 / (double)(ns_end - ns_start));
+}
+
+
+/**
+ * @brief selects and calibrates the time source
+ *
+ * @param timer     the requested time source
+ */
+static void plat_timer_init(plat_timer_t timer)
+{
+    if (timer == PLAT_TIMER_DEFAULT || timer == PLAT_TIMER_TSC) {
+        if (tsc_is_invariant()) {
+            plat_ticks_per_ms = tsc_calibrate();
+            plat_timer = PLAT_TIMER_TSC;
+            LOG_INFO("using invariant TSC timer. calibrated to %" PRIu64 " kHz\n",
+                     plat_ticks_per_ms);
+            return;
+        }
+
+        if (timer == PLAT_TIMER_TSC) {
+            LOG_WARN("TSC is not invariant, falling back to the monotonic clock\n");
+        }
+    }
+
+    plat_ticks_per_ms = 1000000UL;
+    plat_timer = PLAT_TIMER_MONOTONIC;
+    LOG_INFO("using monotonic clock timer.\n");
+}
+
 
 /**
  * @brief reads the time time
@@ -595,9 +1265,11 @@ static inline uint64_t rdtscp(void)
  */
 plat_time_t plat_get_time(void)
 {
-    struct timespec t;
-    clock_gettime(CLOCK_REALTIME, &t);
-    return (uint64_t)(t.tv_sec * 1000000000UL + t.tv_nsec);
+    if (plat_timer == PLAT_TIMER_TSC) {
+        return rdtscp_fenced();
+    }
+
+    return monotonic_ns();
 }
 
 
@@ -610,7 +1282,7 @@ plat_time_t plat_get_time(void)
  */
 plat_time_t plat_convert_time(uint32_t ms)
 {
-    return (plat_time_t)ms * 1000000UL;
+    return (plat_time_t)ms * plat_ticks_per_ms;
 }
 
 
@@ -623,7 +1295,7 @@ plat_time_t plat_convert_time(uint32_t ms)
  */
 double plat_time_to_ms(plat_time_t time)
 {
-    return (double)time / 1000000.0;
+    return (double)time / (double)plat_ticks_per_ms;
 }
 
 
@@ -637,6 +1309,621 @@ void plat_usleep(uint32_t us)
     usleep(us);
 }
 
+/*
+ * ================================================================================================
+ * Performance Counters
+ * ================================================================================================
+ */
+
+
+///< holds the file descriptors of an opened counter group
+struct plat_perfctr {
+    int leader;                     ///< the group leader, -1 if the group could not be opened
+    uint32_t nevents;               ///< number of events that were opened in the group
+    int fds[PLAT_PERFCTR_MAX];      ///< the file descriptors of the events
+    uint32_t idx[PLAT_PERFCTR_MAX]; ///< the position of the event in the group read
+};
+
+///< the layout of a group read with PERF_FORMAT_GROUP
+struct perfctr_read_format {
+    uint64_t nr;
+    uint64_t time_enabled;
+    uint64_t time_running;
+    uint64_t values[PLAT_PERFCTR_MAX];
+};
+
+
+static void perfctr_attr(struct perf_event_attr *attr, plat_perfctr_event_t event)
+{
+    memset(attr, 0, sizeof(*attr));
+    attr->size = sizeof(*attr);
+    attr->disabled = 0;
+    attr->exclude_hv = 1;
+    attr->read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED
+                        | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    switch (event) {
+    case PLAT_PERFCTR_CYCLES:
+        attr->type = PERF_TYPE_HARDWARE;
+        attr->config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+    case PLAT_PERFCTR_INSTRUCTIONS:
+        attr->type = PERF_TYPE_HARDWARE;
+        attr->config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+    case PLAT_PERFCTR_DTLB_MISSES:
+        attr->type = PERF_TYPE_HW_CACHE;
+        attr->config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                       | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        break;
+    case PLAT_PERFCTR_ITLB_MISSES:
+        attr->type = PERF_TYPE_HW_CACHE;
+        attr->config = PERF_COUNT_HW_CACHE_ITLB | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                       | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        break;
+    case PLAT_PERFCTR_CYCLES_USER:
+        attr->type = PERF_TYPE_HARDWARE;
+        attr->config = PERF_COUNT_HW_CPU_CYCLES;
+        attr->exclude_kernel = 1;
+        break;
+    case PLAT_PERFCTR_CYCLES_KERNEL:
+        attr->type = PERF_TYPE_HARDWARE;
+        attr->config = PERF_COUNT_HW_CPU_CYCLES;
+        attr->exclude_user = 1;
+        break;
+    default:
+        break;
+    }
+}
+
+
+/**
+ * @brief opens the performance counters for the calling thread
+ *
+ * @param perfctr   returns the handle to the counter group
+ *
+ * @returns error value
+ *
+ * Events that are not supported by the processor are reported as zero.
+ */
+plat_error_t plat_perfctr_open(plat_perfctr_t *perfctr)
+{
+    if (perfctr == NULL) {
+        return PLAT_ERR_ARGS_INVALID;
+    }
+
+    struct plat_perfctr *ctr = malloc(sizeof(struct plat_perfctr));
+    if (ctr == NULL) {
+        return PLAT_ERR_NO_MEM;
+    }
+
+    ctr->leader = -1;
+    ctr->nevents = 0;
+
+    for (uint32_t i = 0; i < PLAT_PERFCTR_MAX; i++) {
+        struct perf_event_attr attr;
+        perfctr_attr(&attr, i);
+
+        /* count the calling thread on whatever cpu it runs */
+        int fd = syscall(SYS_perf_event_open, &attr, 0, -1, ctr->leader, 0);
+        ctr->fds[i] = fd;
+        if (fd == -1) {
+            if (ctr->leader == -1) {
+                LOG_WARN("could not open the perf event group: %s\n", strerror(errno));
+                free(ctr);
+                return PLAT_ERR_PERFCTR;
+            }
+            LOG_WARN("perf event %u not supported: %s\n", i, strerror(errno));
+            continue;
+        }
+
+        if (ctr->leader == -1) {
+            ctr->leader = fd;
+        }
+        ctr->idx[i] = ctr->nevents++;
+    }
+
+    *perfctr = (plat_perfctr_t)ctr;
+
+    return PLAT_ERR_OK;
+}
+
+
+/**
+ * @brief reads the current values of the performance counters
+ *
+ * @param perfctr   the counter group opened by the calling thread
+ * @param values    returns the values indexed by plat_perfctr_event_t
+ *
+ * @returns error value
+ */
+plat_error_t plat_perfctr_read(plat_perfctr_t perfctr, uint64_t values[PLAT_PERFCTR_MAX])
+{
+    struct plat_perfctr *ctr = (struct plat_perfctr *)perfctr;
+    if (ctr == NULL) {
+        return PLAT_ERR_ARGS_INVALID;
+    }
+
+    struct perfctr_read_format data;
+    if (read(ctr->leader, &data, sizeof(data)) <= 0) {
+        return PLAT_ERR_PERFCTR;
+    }
+
+    /* scale the values if the group was multiplexed with other events */
+    double scale = 1.0;
+    if (data.time_running != 0 && data.time_running < data.time_enabled) {
+        scale = (double)data.time_enabled / (double)data.time_running;
+    }
+
+    for (uint32_t i = 0; i < PLAT_PERFCTR_MAX; i++) {
+        if (ctr->fds[i] == -1 || ctr->idx[i] >= data.nr) {
+            values[i] = 0;
+        } else {
+            values[i] = (uint64_t)((double)data.values[ctr->idx[i]] * scale);
+        }
+    }
+
+    return PLAT_ERR_OK;
+}
+
+
+/**
+ * @brief closes the performance counters
+ *
+ * @param perfctr   the counter group to close
+ *
+ * @returns error value
+ */
+plat_error_t plat_perfctr_close(plat_perfctr_t perfctr)
+{
+    struct plat_perfctr *ctr = (struct plat_perfctr *)perfctr;
+    if (ctr == NULL) {
+        return PLAT_ERR_ARGS_INVALID;
+    }
+
+    /* close the group members before the leader */
+    for (uint32_t i = PLAT_PERFCTR_MAX; i > 0; i--) {
+        if (ctr->fds[i - 1] != -1) {
+            close(ctr->fds[i - 1]);
+        }
+    }
+
+    free(ctr);
+
+    return PLAT_ERR_OK;
+}
+
+
+/*
+ * ================================================================================================
+ * Interrupt Accounting
+ * ================================================================================================
+ */
+
+
+///< the mount points of the tracing file system
+static const char *irqstats_tracefs[] = { "/sys/kernel/tracing", "/sys/kernel/debug/tracing" };
+
+///< the histogram trigger that counts the TLB flush events by reason
+#define IRQSTATS_TLBFLUSH_TRIGGER "hist:keys=reason"
+
+
+struct plat_irqstats
+{
+    char trigger[128];                     ///< trigger file of the tlb_flush event, if installed
+    char hist[128];                        ///< histogram file of the tlb_flush event, if available
+    char *line;                            ///< line buffer for reading the files
+    size_t linesz;                         ///< size of the line buffer
+    uint32_t cols[PLAT_IRQSTATS_MAX_CORES];  ///< core id of each column in /proc/interrupts
+};
+
+
+/**
+ * @brief writes a command to the trigger file of a trace event
+ *
+ * @param path  the path of the trigger file
+ * @param cmd   the trigger command
+ *
+ * @returns 0 on success, the errno value on failure
+ */
+static int irqstats_write_trigger(const char *path, const char *cmd)
+{
+    int fd = open(path, O_WRONLY);
+    if (fd == -1) {
+        return errno;
+    }
+
+    int ret = 0;
+    if (write(fd, cmd, strlen(cmd)) == -1) {
+        ret = errno;
+    }
+
+    close(fd);
+
+    return ret;
+}
+
+
+/**
+ * @brief opens the interrupt accounting of the system
+ *
+ * @param irqstats  returns the handle to the interrupt accounting
+ *
+ * @returns error value
+ *
+ * The TLB flushes are only counted if the kernel's tracing facility is accessible.
+ */
+plat_error_t plat_irqstats_open(plat_irqstats_t *irqstats)
+{
+    if (irqstats == NULL) {
+        return PLAT_ERR_ARGS_INVALID;
+    }
+
+    if (access("/proc/interrupts", R_OK) != 0) {
+        LOG_WARN("cannot read /proc/interrupts: %s\n", strerror(errno));
+        return PLAT_ERR_IRQSTATS;
+    }
+
+    struct plat_irqstats *st = calloc(1, sizeof(struct plat_irqstats));
+    if (st == NULL) {
+        return PLAT_ERR_NO_MEM;
+    }
+
+    for (size_t i = 0; i < sizeof(irqstats_tracefs) / sizeof(irqstats_tracefs[0]); i++) {
+        char path[sizeof(st->trigger)];
+        snprintf(path, sizeof(path), "%s/events/tlb/tlb_flush/trigger", irqstats_tracefs[i]);
+
+        /* an already installed trigger is shared, but not removed when closing */
+        int ret = irqstats_write_trigger(path, IRQSTATS_TLBFLUSH_TRIGGER);
+        if (ret != 0 && ret != EEXIST) {
+            continue;
+        }
+
+        snprintf(st->hist, sizeof(st->hist), "%s/events/tlb/tlb_flush/hist", irqstats_tracefs[i]);
+        if (ret == 0) {
+            strcpy(st->trigger, path);
+        }
+        break;
+    }
+
+    if (st->hist[0] == '\0') {
+        LOG_INFO("tlb:tlb_flush tracepoint not accessible, not counting flushes by reason\n");
+    }
+
+    *irqstats = (plat_irqstats_t)st;
+
+    return PLAT_ERR_OK;
+}
+
+
+/**
+ * @brief reads the per-core IPI counts from /proc/interrupts
+ *
+ * @param st        the interrupt accounting state
+ * @param counts    returns the current counts
+ *
+ * @returns error value
+ */
+static plat_error_t irqstats_read_interrupts(struct plat_irqstats *st,
+                                             struct plat_irqcounts *counts)
+{
+    FILE *f = fopen("/proc/interrupts", "r");
+    if (f == NULL) {
+        return PLAT_ERR_IRQSTATS;
+    }
+
+    /* the header line names the online cores, one column each */
+    uint32_t ncols = 0;
+    if (getline(&st->line, &st->linesz, f) < 0) {
+        fclose(f);
+        return PLAT_ERR_IRQSTATS;
+    }
+
+    char *saveptr;
+    for (char *tok = strtok_r(st->line, " \t\n", &saveptr); tok != NULL;
+         tok = strtok_r(NULL, " \t\n", &saveptr)) {
+        uint32_t core;
+        if (sscanf(tok, "CPU%u", &core) == 1 && ncols < PLAT_IRQSTATS_MAX_CORES) {
+            st->cols[ncols++] = core;
+        }
+    }
+
+    while (getline(&st->line, &st->linesz, f) >= 0) {
+        char *p = st->line;
+        while (*p == ' ') {
+            p++;
+        }
+
+        plat_ipi_t ipi;
+        if (strncmp(p, "TLB:", 4) == 0) {
+            ipi = PLAT_IPI_TLB_SHOOTDOWN;
+        } else if (strncmp(p, "CAL:", 4) == 0) {
+            ipi = PLAT_IPI_FUNCTION_CALL;
+        } else {
+            continue;
+        }
+
+        p += 4;
+        for (uint32_t i = 0; i < ncols; i++) {
+            char *end;
+            uint64_t val = strtoull(p, &end, 10);
+            if (end == p) {
+                break;
+            }
+            if (st->cols[i] < PLAT_IRQSTATS_MAX_CORES) {
+                counts->ipis[st->cols[i]][ipi] = val;
+            }
+            p = end;
+        }
+    }
+
+    fclose(f);
+
+    return PLAT_ERR_OK;
+}
+
+
+/**
+ * @brief reads the TLB flush counts by reason from the tracepoint histogram
+ *
+ * @param st        the interrupt accounting state
+ * @param counts    returns the current counts
+ */
+static void irqstats_read_tlbflush(struct plat_irqstats *st, struct plat_irqcounts *counts)
+{
+    if (st->hist[0] == '\0') {
+        return;
+    }
+
+    FILE *f = fopen(st->hist, "r");
+    if (f == NULL) {
+        return;
+    }
+
+    /* the entries have the form '{ reason:          1 } hitcount:        123' */
+    while (getline(&st->line, &st->linesz, f) >= 0) {
+        uint32_t reason;
+        uint64_t hits;
+        if (sscanf(st->line, " { reason: %u } hitcount: %" SCNu64, &reason, &hits) == 2
+            && reason < PLAT_TLBFLUSH_MAX) {
+            counts->tlbflush[reason] = hits;
+        }
+    }
+
+    fclose(f);
+
+    counts->has_tlbflush = true;
+}
+
+
+/**
+ * @brief takes a snapshot of the interrupt counts
+ *
+ * @param irqstats  the interrupt accounting handle
+ * @param counts    returns the current counts
+ *
+ * @returns error value
+ */
+plat_error_t plat_irqstats_read(plat_irqstats_t irqstats, struct plat_irqcounts *counts)
+{
+    struct plat_irqstats *st = (struct plat_irqstats *)irqstats;
+    if (st == NULL || counts == NULL) {
+        return PLAT_ERR_ARGS_INVALID;
+    }
+
+    memset(counts, 0, sizeof(*counts));
+
+    irqstats_read_tlbflush(st, counts);
+
+    return irqstats_read_interrupts(st, counts);
+}
+
+
+/**
+ * @brief closes the interrupt accounting
+ *
+ * @param irqstats  the interrupt accounting handle
+ *
+ * @returns error value
+ */
+plat_error_t plat_irqstats_close(plat_irqstats_t irqstats)
+{
+    struct plat_irqstats *st = (struct plat_irqstats *)irqstats;
+    if (st == NULL) {
+        return PLAT_ERR_ARGS_INVALID;
+    }
+
+    if (st->trigger[0] != '\0') {
+        irqstats_write_trigger(st->trigger, "!" IRQSTATS_TLBFLUSH_TRIGGER);
+    }
+
+    free(st->line);
+    free(st);
+
+    return PLAT_ERR_OK;
+}
+
+
+/*
+ * ================================================================================================
+ * System Environment
+ * ================================================================================================
+ */
+
+
+/**
+ * @brief reads the first line of a file without the trailing newline
+ *
+ * @param path  the path of the file
+ * @param buf   the buffer to read the line into
+ * @param size  the size of the buffer
+ *
+ * @returns true if the line could be read, false otherwise
+ */
+static bool env_read_line(const char *path, char *buf, size_t size)
+{
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return false;
+    }
+
+    bool ok = fgets(buf, size, f) != NULL;
+    fclose(f);
+
+    if (ok) {
+        buf[strcspn(buf, "\n")] = 0;
+    }
+
+    return ok;
+}
+
+
+/**
+ * @brief reports the first line of a file as a property
+ *
+ * @param fn    the function called for the property
+ * @param st    the state passed to the function
+ * @param group the group of the property
+ * @param key   the name of the property
+ * @param path  the path of the file
+ */
+static void env_report_file(plat_env_fn_t fn, void *st, const char *group, const char *key,
+                            const char *path)
+{
+    char buf[4096];
+    if (env_read_line(path, buf, sizeof(buf))) {
+        fn(st, group, key, buf);
+    }
+}
+
+
+/**
+ * @brief reports the selected value of a sysfs setting such as 'always [madvise] never'
+ *
+ * @param fn    the function called for the property
+ * @param st    the state passed to the function
+ * @param key   the name of the property
+ * @param path  the path of the sysfs file
+ */
+static void env_report_selected(plat_env_fn_t fn, void *st, const char *key, const char *path)
+{
+    char buf[256];
+    if (!env_read_line(path, buf, sizeof(buf))) {
+        return;
+    }
+
+    char *start = strchr(buf, '[');
+    char *end = start != NULL ? strchr(start, ']') : NULL;
+    if (end != NULL) {
+        *end = 0;
+        fn(st, NULL, key, start + 1);
+    } else {
+        fn(st, NULL, key, buf);
+    }
+}
+
+
+/**
+ * @brief reports a file of each entry of a sysfs directory as a group of properties
+ *
+ * @param fn        the function called for each property
+ * @param st        the state passed to the function
+ * @param group     the group of the properties
+ * @param dir       the sysfs directory
+ * @param prefix    only entries with this prefix are reported, the key omits the prefix
+ * @param file      the file within each entry, NULL if the entries are files themselves
+ */
+static void env_report_dir(plat_env_fn_t fn, void *st, const char *group, const char *dir,
+                           const char *prefix, const char *file)
+{
+    DIR *d = opendir(dir);
+    if (d == NULL) {
+        return;
+    }
+
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL) {
+        if (e->d_name[0] == '.' || strncmp(e->d_name, prefix, strlen(prefix)) != 0) {
+            continue;
+        }
+
+        char path[512];
+        if (file != NULL) {
+            snprintf(path, sizeof(path), "%s/%s/%s", dir, e->d_name, file);
+        } else {
+            snprintf(path, sizeof(path), "%s/%s", dir, e->d_name);
+        }
+
+        env_report_file(fn, st, group, e->d_name + strlen(prefix), path);
+    }
+
+    closedir(d);
+}
+
+
+/**
+ * @brief reports the properties of the system environment that affect the results
+ *
+ * @param fn    the function called for each property
+ * @param st    the state passed to the function
+ *
+ * @returns error value
+ *
+ * The properties of a group are reported one after the other.
+ */
+plat_error_t plat_get_environment(plat_env_fn_t fn, void *st)
+{
+    char buf[256];
+
+    fn(st, NULL, "os", "linux");
+
+    struct utsname uts;
+    if (uname(&uts) == 0) {
+        fn(st, NULL, "hostname", uts.nodename);
+        fn(st, NULL, "kernel", uts.release);
+        fn(st, NULL, "kernel_version", uts.version);
+        fn(st, NULL, "machine", uts.machine);
+    }
+
+    env_report_file(fn, st, NULL, "boot_cmdline", "/proc/cmdline");
+    env_report_selected(fn, st, "thp_enabled", "/sys/kernel/mm/transparent_hugepage/enabled");
+    env_report_selected(fn, st, "thp_defrag", "/sys/kernel/mm/transparent_hugepage/defrag");
+    env_report_file(fn, st, NULL, "max_map_count", "/proc/sys/vm/max_map_count");
+
+    snprintf(buf, sizeof(buf), "%d", get_nprocs());
+    fn(st, NULL, "ncpus", buf);
+
+    /* the cpu model is the same on all cores */
+    FILE *f = fopen("/proc/cpuinfo", "r");
+    if (f != NULL) {
+        char line[512];
+        while (fgets(line, sizeof(line), f) != NULL) {
+            char *sep = strchr(line, ':');
+            if (strncmp(line, "model name", 10) == 0 && sep != NULL) {
+                line[strcspn(line, "\n")] = 0;
+                fn(st, NULL, "cpu_model", sep + 2);
+                break;
+            }
+        }
+        fclose(f);
+    }
+
+    env_report_file(fn, st, NULL, "cpu_governor",
+                    "/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor");
+
+    snprintf(buf, sizeof(buf), "%d", numa_available() < 0 ? 1 : numa_max_node() + 1);
+    fn(st, NULL, "numa_nodes", buf);
+
+    env_report_dir(fn, st, "numa_cpus", "/sys/devices/system/node", "node", "cpulist");
+    env_report_dir(fn, st, "hugepages", "/sys/kernel/mm/hugepages", "hugepages-",
+                   "nr_hugepages");
+    env_report_dir(fn, st, "vulnerabilities", "/sys/devices/system/cpu/vulnerabilities", "",
+                   NULL);
+
+    return PLAT_ERR_OK;
+}
+
+
 /*
  * ================================================================================================
  * Logging Functions
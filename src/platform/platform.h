@@ -16,6 +16,8 @@
 
 #define PLAT_ARCH_BASE_PAGE_SIZE (1 << 12)
 #define PLAT_ARCH_HUGE_PAGE_SIZE (1 << 21)
+#define PLAT_ARCH_GIANT_PAGE_SIZE (1 << 30)
+#define PLAT_ARCH_CACHELINE_SIZE 64
 
 ///< forward declaration
 struct vmops_bench_run_arg;
@@ -41,6 +43,10 @@ typedef enum {
     PLAT_ERR_THREAD_JOIN,
     PLAT_ERR_FILE_OPEN,
     PLAT_ERR_BARRIER,
+    PLAT_ERR_NOT_SUPPORTED,
+    PLAT_ERR_PERFCTR,
+    PLAT_ERR_IRQSTATS,
+    PLAT_ERR_SYNC_FAILED,
 } plat_error_t;
 
 
@@ -104,6 +110,50 @@ plat_error_t plat_get_topology(plat_topo_numa_t numapolicy, plat_topo_cores_t co
 ///< opaque file descriptor / pointer to a memory object
 typedef void *plat_memobj_t;
 
+///< the backend of a memory object
+typedef enum {
+    PLAT_MEMOBJ_MEMFD,         ///< an anonymous shared memory file, a frame on Barrelfish
+    PLAT_MEMOBJ_ANON_PRIVATE,  ///< private anonymous memory, created by each mapping
+    PLAT_MEMOBJ_ANON_SHARED,   ///< shared anonymous memory, created by each mapping
+    PLAT_MEMOBJ_SHM,           ///< a named POSIX shared memory object
+    PLAT_MEMOBJ_FILE,          ///< a sparse file, the path names the file in a directory
+    PLAT_MEMOBJ_FILE_PREALLOC, ///< a file with all of its blocks allocated
+    PLAT_MEMOBJ_MAX
+} plat_memobj_type_t;
+
+///< the pages that back a mapping
+typedef enum {
+    PLAT_PAGE_BASE,     ///< base pages
+    PLAT_PAGE_HUGE_2M,  ///< 2 MiB pages from the reserved huge page pool
+    PLAT_PAGE_HUGE_1G,  ///< 1 GiB pages from the reserved huge page pool
+    PLAT_PAGE_THP,      ///< 2 MiB aligned mappings advised to use transparent huge pages
+    PLAT_PAGE_MAX
+} plat_page_t;
+
+
+/**
+ * @brief obtains the size of the pages a mapping is made of
+ *
+ * @param page  the pages of the mapping
+ *
+ * @returns the page size in bytes
+ *
+ * Mappings with transparent huge pages are made of huge pages, the kernel may still back
+ * parts of them with base pages.
+ */
+static inline size_t plat_page_size(plat_page_t page)
+{
+    switch (page) {
+    case PLAT_PAGE_HUGE_2M:
+    case PLAT_PAGE_THP:
+        return PLAT_ARCH_HUGE_PAGE_SIZE;
+    case PLAT_PAGE_HUGE_1G:
+        return PLAT_ARCH_GIANT_PAGE_SIZE;
+    default:
+        return PLAT_ARCH_BASE_PAGE_SIZE;
+    }
+}
+
 
 /**
  * @brief creates a memory object for the benchmark
@@ -111,11 +161,16 @@ typedef void *plat_memobj_t;
  * @param path      the name/path of the memobj
  * @param memobj    returns a pointer to the created memory object
  * @param size      the maximum size for the memory object
- * @param huge      use huge pages for this memory object
+ * @param page      the pages of the memory object
+ * @param type      the backend of the memory object
  *
  * @returns error value
+ *
+ * Mappings of anonymous memory objects do not share their pages with other mappings of the
+ * same memory object, and the offset into the memory object is ignored.
  */
-plat_error_t plat_vm_create(const char *path, plat_memobj_t *memobj, size_t size, bool huge);
+plat_error_t plat_vm_create(const char *path, plat_memobj_t *memobj, size_t size,
+                            plat_page_t page, plat_memobj_type_t type);
 
 
 /**
@@ -135,11 +190,12 @@ plat_error_t plat_vm_destroy(plat_memobj_t memobj);
  * @param size      the size of the mapping to be created
  * @param memobj    the backing memory object for this mapping
  * @param offset    the offset into the memory object
- * @param huge      use a huge page mapping
+ * @param page      the pages of the mapping
  *
  * @returns returned error value
  */
-plat_error_t plat_vm_map(void **addr, size_t size, plat_memobj_t memobj, off_t offset, bool huge);
+plat_error_t plat_vm_map(void **addr, size_t size, plat_memobj_t memobj, off_t offset,
+                         plat_page_t page);
 
 
 /**
@@ -149,12 +205,29 @@ plat_error_t plat_vm_map(void **addr, size_t size, plat_memobj_t memobj, off_t o
  * @param size      the size of the mapping to be created
  * @param memobj    the backing memory object for this mapping
  * @param offset    the offset into the memory object
- * @param huge      use a huge page mapping
+ * @param page      the pages of the mapping
  *
  * @returns returned error value
  */
 plat_error_t plat_vm_map_fixed(void *addr, size_t size, plat_memobj_t memobj, off_t offset,
-                               bool huge);
+                               plat_page_t page);
+
+
+/**
+ * @brief maps a region of the memory object without populating the page tables
+ *
+ * @param addr      the address to map at if not NULL, returns the address of the mapping
+ * @param size      the size of the mapping to be created
+ * @param memobj    the backing memory object for this mapping
+ * @param offset    the offset into the memory object
+ * @param page      the pages of the mapping
+ *
+ * @returns returned error value
+ *
+ * The pages of the mapping are faulted in on their first access.
+ */
+plat_error_t plat_vm_map_lazy(void **addr, size_t size, plat_memobj_t memobj, off_t offset,
+                              plat_page_t page);
 
 
 /**
@@ -178,6 +251,48 @@ typedef enum {
 plat_error_t plat_vm_protect(void *addr, size_t size, plat_perm_t perms);
 
 
+/**
+ * @brief writes the dirty pages of a mapped memory region back to the memory object
+ *
+ * @param addr      the start of the memory region
+ * @param size      the size of the memory region
+ *
+ * @returns error value
+ *
+ * Returns once the pages have been written back, the pages remain mapped.
+ */
+plat_error_t plat_vm_sync(void *addr, size_t size);
+
+
+/**
+ * @brief how a mapping is changed when it is remapped
+ */
+typedef enum {
+    PLAT_REMAP_RESIZE,     ///< grow or shrink the mapping in place
+    PLAT_REMAP_MOVE,       ///< move the mapping to a new address
+    PLAT_REMAP_DONTUNMAP,  ///< move the pages to a new address, keep the old range mapped
+} plat_remap_t;
+
+
+/**
+ * @brief resizes or moves a mapping
+ *
+ * @param addr      the address of the mapping
+ * @param size      the size of the mapping
+ * @param new_addr  the address to move to if not NULL, returns the new address of the mapping
+ * @param new_size  the new size of the mapping
+ * @param mode      how the mapping is changed
+ *
+ * @returns error value
+ *
+ * A mapping that is moved to a given address replaces any mapping at that address. With
+ * PLAT_REMAP_DONTUNMAP, the old range remains mapped without any pages and the size must
+ * not change.
+ */
+plat_error_t plat_vm_remap(void *addr, size_t size, void **new_addr, size_t new_size,
+                           plat_remap_t mode);
+
+
 /**
  * @brief unmaps a previously mapped memory region
  *
@@ -189,6 +304,89 @@ plat_error_t plat_vm_protect(void *addr, size_t size, plat_perm_t perms);
 plat_error_t plat_vm_unmap(void *addr, size_t size);
 
 
+/**
+ * @brief releases the pages backing a mapped memory region
+ *
+ * @param addr      the start of the memory region
+ * @param size      the size of the memory region
+ * @param memobj    the memory object backing the region
+ *
+ * @returns error value
+ *
+ * The mapping is retained. The next access to a page of the region faults in a zero-filled
+ * page again.
+ */
+plat_error_t plat_vm_discard(void *addr, size_t size, plat_memobj_t memobj);
+
+
+/**
+ * @brief obtains the size of the pages the kernel backs a mapping with
+ *
+ * @param addr      an address within the mapping
+ * @param pagesize  returns the size of the largest page that backs the mapping
+ *
+ * @returns error value
+ *
+ * The mapping should be populated, a mapping without any pages has the base page size.
+ */
+plat_error_t plat_vm_page_size(void *addr, size_t *pagesize);
+
+
+/**
+ * @brief counts the mappings of the address space
+ *
+ * @param count     returns the number of mappings
+ *
+ * @returns error value
+ *
+ * Adjacent mappings with the same properties may be counted as one mapping.
+ */
+plat_error_t plat_vm_count_mappings(size_t *count);
+
+
+/*
+ * ================================================================================================
+ * Memory Placement
+ * ================================================================================================
+ */
+
+
+/**
+ * @brief allocates page-aligned memory that is not yet backed by physical pages
+ *
+ * @param size      the size of the allocation
+ * @param ret       returns the address of the allocated memory, zero-filled on first touch
+ *
+ * @returns error value
+ *
+ * The memory is shared with processes started with plat_process_start afterwards.
+ */
+plat_error_t plat_mem_alloc(size_t size, void **ret);
+
+
+/**
+ * @brief places the pages of a memory region on the NUMA node of a core
+ *
+ * @param addr      the start of the memory region, rounded down to the page boundary
+ * @param size      the size of the memory region
+ * @param coreid    the core whose local node should hold the memory
+ *
+ * @returns error value
+ *
+ * Pages that have already been touched are not migrated.
+ */
+plat_error_t plat_mem_bind_local(void *addr, size_t size, uint32_t coreid);
+
+
+/**
+ * @brief frees memory allocated with plat_mem_alloc
+ *
+ * @param addr      the address of the allocated memory
+ * @param size      the size of the allocation
+ */
+void plat_mem_free(void *addr, size_t size);
+
+
 /*
  * ================================================================================================
  * Threading Functions
@@ -219,6 +417,22 @@ plat_thread_t plat_thread_start(plat_thread_fn_t run, struct vmops_bench_run_arg
                                 uint32_t coreid);
 
 
+/**
+ * @brief creates and starts a new process that runs a function and exits
+ *
+ * @param run       function to be executed in the process
+ * @param st        state to be passed to the function
+ * @param coreid    the core to run the process on
+ *
+ * @returns handle to the process, or NULL on error
+ *
+ * The handle is joined and cancelled like a thread. The state and any results must be in
+ * memory allocated with plat_mem_alloc to be shared with the process.
+ */
+plat_thread_t plat_process_start(plat_thread_fn_t run, struct vmops_bench_run_arg *st,
+                                 uint32_t coreid);
+
+
 /**
  * @brief initializes a platform barrier
  *
@@ -281,6 +495,16 @@ plat_error_t plat_thread_cancel(plat_thread_t thread);
 typedef uint64_t plat_time_t;
 
 
+/**
+ * @brief the time source backing plat_get_time()
+ */
+typedef enum {
+    PLAT_TIMER_DEFAULT,    ///< let the platform pick the most precise source
+    PLAT_TIMER_TSC,        ///< the (invariant) time stamp counter
+    PLAT_TIMER_MONOTONIC,  ///< the monotonic system clock
+} plat_timer_t;
+
+
 ///< maximum platform time
 #define PLAT_TIME_MAX (UINT64_MAX)
 
@@ -319,6 +543,164 @@ double plat_time_to_ms(plat_time_t time);
  */
 void plat_usleep(uint32_t us);
 
+/*
+ * ================================================================================================
+ * Performance Counters
+ * ================================================================================================
+ */
+
+
+///< the hardware events that are counted per thread
+typedef enum {
+    PLAT_PERFCTR_CYCLES,         ///< cpu cycles
+    PLAT_PERFCTR_INSTRUCTIONS,   ///< retired instructions
+    PLAT_PERFCTR_DTLB_MISSES,    ///< data TLB load misses
+    PLAT_PERFCTR_ITLB_MISSES,    ///< instruction TLB load misses
+    PLAT_PERFCTR_CYCLES_USER,    ///< cpu cycles spent in user mode
+    PLAT_PERFCTR_CYCLES_KERNEL,  ///< cpu cycles spent in kernel mode
+    PLAT_PERFCTR_MAX
+} plat_perfctr_event_t;
+
+
+///< opaque handle to a group of performance counters
+typedef void *plat_perfctr_t;
+
+
+/**
+ * @brief opens the performance counters for the calling thread
+ *
+ * @param perfctr   returns the handle to the counter group
+ *
+ * @returns error value
+ *
+ * Events that are not supported by the processor are reported as zero.
+ */
+plat_error_t plat_perfctr_open(plat_perfctr_t *perfctr);
+
+
+/**
+ * @brief reads the current values of the performance counters
+ *
+ * @param perfctr   the counter group opened by the calling thread
+ * @param values    returns the values indexed by plat_perfctr_event_t
+ *
+ * @returns error value
+ */
+plat_error_t plat_perfctr_read(plat_perfctr_t perfctr, uint64_t values[PLAT_PERFCTR_MAX]);
+
+
+/**
+ * @brief closes the performance counters
+ *
+ * @param perfctr   the counter group to close
+ *
+ * @returns error value
+ */
+plat_error_t plat_perfctr_close(plat_perfctr_t perfctr);
+
+
+/*
+ * ================================================================================================
+ * Interrupt Accounting
+ * ================================================================================================
+ */
+
+
+///< the inter-processor interrupts counted per core
+typedef enum {
+    PLAT_IPI_TLB_SHOOTDOWN,  ///< TLB shootdown interrupts
+    PLAT_IPI_FUNCTION_CALL,  ///< function call interrupts
+    PLAT_IPI_MAX
+} plat_ipi_t;
+
+
+///< the reasons of TLB flushes reported by the tracepoint
+typedef enum {
+    PLAT_TLBFLUSH_TASK_SWITCH,        ///< flush on a context switch
+    PLAT_TLBFLUSH_REMOTE_SHOOTDOWN,   ///< flush requested by another core
+    PLAT_TLBFLUSH_LOCAL_SHOOTDOWN,    ///< flush of a range on the local core
+    PLAT_TLBFLUSH_LOCAL_MM_SHOOTDOWN, ///< flush of the entire address space on the local core
+    PLAT_TLBFLUSH_REMOTE_SEND_IPI,    ///< shootdown IPI sent to other cores
+    PLAT_TLBFLUSH_MAX
+} plat_tlbflush_t;
+
+
+///< the maximum number of cores for which interrupts are accounted
+#define PLAT_IRQSTATS_MAX_CORES 512
+
+
+///< a snapshot of the interrupt counts of the system
+struct plat_irqcounts
+{
+    ///< the interrupts received by each core, indexed by core id
+    uint64_t ipis[PLAT_IRQSTATS_MAX_CORES][PLAT_IPI_MAX];
+    ///< the number of TLB flush events by reason, valid if has_tlbflush is set
+    uint64_t tlbflush[PLAT_TLBFLUSH_MAX];
+    bool has_tlbflush;
+};
+
+
+///< opaque handle to the interrupt accounting
+typedef void *plat_irqstats_t;
+
+
+/**
+ * @brief opens the interrupt accounting of the system
+ *
+ * @param irqstats  returns the handle to the interrupt accounting
+ *
+ * @returns error value
+ *
+ * The TLB flushes are only counted if the kernel's tracing facility is accessible.
+ */
+plat_error_t plat_irqstats_open(plat_irqstats_t *irqstats);
+
+
+/**
+ * @brief takes a snapshot of the interrupt counts
+ *
+ * @param irqstats  the interrupt accounting handle
+ * @param counts    returns the current counts
+ *
+ * @returns error value
+ */
+plat_error_t plat_irqstats_read(plat_irqstats_t irqstats, struct plat_irqcounts *counts);
+
+
+/**
+ * @brief closes the interrupt accounting
+ *
+ * @param irqstats  the interrupt accounting handle
+ *
+ * @returns error value
+ */
+plat_error_t plat_irqstats_close(plat_irqstats_t irqstats);
+
+
+/*
+ * ================================================================================================
+ * System Environment
+ * ================================================================================================
+ */
+
+
+///< receives a property of the system environment, group is NULL for top-level properties
+typedef void (*plat_env_fn_t)(void *st, const char *group, const char *key, const char *value);
+
+
+/**
+ * @brief reports the properties of the system environment that affect the results
+ *
+ * @param fn    the function called for each property
+ * @param st    the state passed to the function
+ *
+ * @returns error value
+ *
+ * The properties of a group are reported one after the other.
+ */
+plat_error_t plat_get_environment(plat_env_fn_t fn, void *st);
+
+
 /*
  * ================================================================================================
  * Logging Functions